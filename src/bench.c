@@ -0,0 +1,173 @@
+#include "bench.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "search.h"
+#include "search_pool.h"
+#include "transposition_table.h"
+#include "utils.h"
+
+// "Perft Results", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Perft_Results
+static const char* BENCH_FENS[] =
+{
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+#define BENCH_FENS_SIZE (sizeof(BENCH_FENS) / sizeof(BENCH_FENS[0]))
+
+size_t bench_search_verify(uint64_t depth)
+{
+    size_t mismatches = 0;
+    for (size_t i=0; i<BENCH_FENS_SIZE; ++i)
+    {
+        BoardState state = {0};
+        board_state_set_fen_string(&state, BENCH_FENS[i], strlen(BENCH_FENS[i]));
+        const double minimax_start           = time_now_seconds();
+        const evaluation_t minimax_evaluation = board_state_evaluate_minimax(&state, depth);
+        const double minimax_time            = time_now_seconds() - minimax_start;
+        SearchThread thread;
+        search_thread_init(&thread, NULL);
+        thread.params.is_quiescence_enabled = false;
+        thread.params.is_pruning_enabled    = false;
+        thread.params.is_extensions_enabled = false;
+        const double search_start           = time_now_seconds();
+        const evaluation_t search_evaluation = search_root(&thread, &state, depth);
+        const double search_time            = time_now_seconds() - search_start;
+        const bool is_match = minimax_evaluation == search_evaluation;
+        if (!is_match)
+            ++mismatches;
+        printf("%zu: minimax %d (%.3fs), alphabeta %d (%.3fs, %llu nodes) %s\n",
+            i+1, (int)minimax_evaluation, minimax_time, (int)search_evaluation, search_time,
+            (unsigned long long)thread.stats.nodes, is_match ? "OK" : "MISMATCH");
+    }
+    printf("mismatches(depth=%llu): %zu/%zu\n", (unsigned long long)depth, mismatches, BENCH_FENS_SIZE);
+    return mismatches;
+}
+
+static uint64_t bench_search_params(uint64_t depth, const SearchParams* params, SearchStats* total_stats, double* total_time_out)
+{
+    uint64_t total_nodes=0, total_cutoffs=0, total_first_move_cutoffs=0, total_quiet_cutoffs=0, total_quiet_cutoff_moves=0;
+    double total_time = 0;
+    TranspositionTable tt = {0};
+    transposition_table_alloc(&tt, BENCH_HASH_SIZE);
+    for (size_t i=0; i<BENCH_FENS_SIZE; ++i)
+    {
+        BoardState state = {0};
+        board_state_set_fen_string(&state, BENCH_FENS[i], strlen(BENCH_FENS[i]));
+        transposition_table_clear(&tt);
+        SearchThread thread;
+        search_thread_init(&thread, &tt);
+        thread.params       = *params;
+        thread.limits.depth = depth;
+        const double start              = time_now_seconds();
+        const evaluation_t evaluation   = search_iterative_deepening(&thread, &state, NULL);
+        const double time               = time_now_seconds() - start;
+        char bestmove_str[MOVE_TO_STRING_SIZE];
+        move_to_string(&thread.bestmove, bestmove_str, MOVE_TO_STRING_SIZE);
+        printf("%zu: bestmove %s, score %d, %llu nodes, %.3fs, first move cutoffs %.1f%%\n",
+            i+1, bestmove_str, (int)evaluation, (unsigned long long)thread.stats.nodes, time,
+            thread.stats.beta_cutoffs ? 100.0 * thread.stats.first_move_cutoffs / thread.stats.beta_cutoffs : 0.0);
+        total_nodes              += thread.stats.nodes;
+        total_cutoffs            += thread.stats.beta_cutoffs;
+        total_first_move_cutoffs += thread.stats.first_move_cutoffs;
+        total_quiet_cutoffs      += thread.stats.quiet_cutoffs;
+        total_quiet_cutoff_moves += thread.stats.quiet_cutoff_moves;
+        total_time               += time;
+        if (total_stats)
+            search_stats_add(total_stats, &thread.stats);
+    }
+    transposition_table_free(&tt);
+    printf("total(depth=%llu): %llu nodes, %.3fs, %.0f nps, first move cutoffs %.1f%%, quiet cutoffs after %.2f quiets\n",
+        (unsigned long long)depth, (unsigned long long)total_nodes, total_time,
+        total_time > 0 ? total_nodes / total_time : 0.0,
+        total_cutoffs ? 100.0 * total_first_move_cutoffs / total_cutoffs : 0.0,
+        total_quiet_cutoffs ? (double)total_quiet_cutoff_moves / total_quiet_cutoffs : 0.0);
+    if (total_time_out)
+        *total_time_out = total_time;
+    return total_nodes;
+}
+
+uint64_t bench_search(uint64_t depth)
+{
+    return bench_search_params(depth, &SEARCH_PARAMS_DEFAULT, NULL, NULL);
+}
+
+static double bench_search_mtdf_params(uint64_t depth, const SearchParams* base_params)
+{
+    SearchParams params = *base_params;
+    SearchStats pvs_stats = {0}, mtdf_stats = {0};
+    double pvs_time = 0, mtdf_time = 0;
+    params.is_mtdf_enabled = false;
+    printf("pvs:\n");
+    bench_search_params(depth, &params, &pvs_stats, &pvs_time);
+    params.is_mtdf_enabled = true;
+    printf("mtdf:\n");
+    bench_search_params(depth, &params, &mtdf_stats, &mtdf_time);
+    const SearchStats* stats[] = { &pvs_stats, &mtdf_stats };
+    const double times[]       = { pvs_time, mtdf_time };
+    const char* names[]        = { "pvs", "mtdf" };
+    for (size_t i=0; i<2; ++i)
+        printf("%s(depth=%llu): %llu nodes, %.3fs, tt hits %.1f%%\n",
+            names[i], (unsigned long long)depth, (unsigned long long)stats[i]->nodes, times[i],
+            stats[i]->tt_probes ? 100.0 * stats[i]->tt_hits / stats[i]->tt_probes : 0.0);
+    const double ratio = pvs_stats.nodes ? (double)mtdf_stats.nodes / pvs_stats.nodes : 0.0;
+    printf("mtdf/pvs: nodes %.2f, time %.2f\n", ratio, pvs_time > 0 ? mtdf_time / pvs_time : 0.0);
+    return ratio;
+}
+
+// the same positions under both root drivers; MTD(f) lives off the table, so its hit rate is reported too.
+// its probes are all zero-window, so with pruning on they prune nodes pvs searches as pv, a different
+// search profile. only the run without pruning compares the drivers, and its ratio is returned
+double bench_search_mtdf(uint64_t depth)
+{
+    SearchParams params = SEARCH_PARAMS_DEFAULT;
+    printf("pruning (different search profiles):\n");
+    bench_search_mtdf_params(depth, &params);
+    params.is_pruning_enabled = false;
+    printf("no pruning (like-for-like):\n");
+    return bench_search_mtdf_params(depth, &params);
+}
+
+// time to depth, the honest measure for Lazy SMP since helpers inflate node counts
+double bench_search_smp(uint64_t depth)
+{
+    static const size_t threads[] = { 1, 2, 4, 8, 16 };
+    TranspositionTable tt = {0};
+    transposition_table_alloc(&tt, BENCH_HASH_SIZE);
+    double base_time = 0, speedup = 0;
+    for (size_t i=0; i<sizeof(threads) / sizeof(threads[0]); ++i)
+    {
+        SearchPool pool;
+        search_pool_alloc(&pool, threads[i], &tt);
+        const SearchLimits limits = { .depth = depth };
+        uint64_t total_nodes = 0;
+        double total_time    = 0;
+        for (size_t j=0; j<BENCH_FENS_SIZE; ++j)
+        {
+            BoardState state = {0};
+            board_state_set_fen_string(&state, BENCH_FENS[j], strlen(BENCH_FENS[j]));
+            transposition_table_clear(&tt);
+            const double start = time_now_seconds();
+            search_pool_start(&pool, &state, &SEARCH_PARAMS_DEFAULT, &limits, NULL, NULL, NULL);
+            search_pool_wait(&pool);
+            total_time  += time_now_seconds() - start;
+            total_nodes += search_pool_get_nodes(&pool);
+        }
+        search_pool_free(&pool);
+        if (i == 0)
+            base_time = total_time;
+        speedup = total_time > 0 ? base_time / total_time : 0.0;
+        printf("threads %zu (depth=%llu): %.3fs, %llu nodes, speedup %.2f\n",
+            threads[i], (unsigned long long)depth, total_time, (unsigned long long)total_nodes, speedup);
+    }
+    transposition_table_free(&tt);
+    return speedup;
+}
+
@@ -0,0 +1,17 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "board_state.h"
+
+#define BENCH_HASH_SIZE 16
+
+size_t bench_search_verify(uint64_t depth);
+uint64_t bench_search(uint64_t depth);
+double bench_search_mtdf(uint64_t depth);
+double bench_search_smp(uint64_t depth);
+
+#endif // BENCH_H
+
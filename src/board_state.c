@@ -7,6 +7,68 @@
 
 #include "utils.h"
 
+// "Zobrist Hashing", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Zobrist_Hashing
+static uint64_t zobrist_keys_pieces[PIECE_BK + 1][BOARD_SIZE];
+static uint64_t zobrist_key_active_color_w;
+// one key per combination of the four castling rights
+static uint64_t zobrist_keys_castling[16];
+static uint64_t zobrist_keys_en_passant[FILE_SIZE];
+
+// filled once before main, so threads only ever read the tables
+__attribute__((constructor)) static void board_state_zobrist_init(void)
+{
+    for (size_t piece=PIECE_WP; piece<=PIECE_BK; ++piece)
+        for (size_t square=0; square<BOARD_SIZE; ++square)
+            zobrist_keys_pieces[piece][square] = splitmix64((uint64_t)piece * BOARD_SIZE + square);
+    zobrist_key_active_color_w = splitmix64((PIECE_BK + 1) * BOARD_SIZE);
+    for (size_t castling=0; castling<=BOARD_STATE_FIELDS_CASTLING; ++castling)
+        zobrist_keys_castling[castling] = splitmix64((PIECE_BK + 1) * BOARD_SIZE + 1 + castling);
+    for (size_t file=0; file<FILE_SIZE; ++file)
+        zobrist_keys_en_passant[file] = splitmix64((PIECE_BK + 2) * BOARD_SIZE + file);
+}
+
+// the keys of every square whose piece differs between the two boards, a full hash against an empty board
+static uint64_t board_state_hash_pieces_diff(const Bitboard* before, const Bitboard* after)
+{
+    uint64_t hash = 0;
+    #define HASH_PIECES(piece, set, is_white) \
+        for (square_t temp = (before->set & (is_white ? before->w : ~before->w)) \
+                ^ (after->set & (is_white ? after->w : ~after->w)); temp; temp &= temp - 1) \
+            hash ^= zobrist_keys_pieces[piece][__builtin_ctzll(temp)];
+    HASH_PIECES(PIECE_WP, p, true)
+    HASH_PIECES(PIECE_WN, n, true)
+    HASH_PIECES(PIECE_WB, b, true)
+    HASH_PIECES(PIECE_WR, r, true)
+    HASH_PIECES(PIECE_WQ, q, true)
+    HASH_PIECES(PIECE_WK, k, true)
+    HASH_PIECES(PIECE_BP, p, false)
+    HASH_PIECES(PIECE_BN, n, false)
+    HASH_PIECES(PIECE_BB, b, false)
+    HASH_PIECES(PIECE_BR, r, false)
+    HASH_PIECES(PIECE_BQ, q, false)
+    HASH_PIECES(PIECE_BK, k, false)
+    #undef HASH_PIECES
+    return hash;
+}
+
+// everything besides the pieces
+static uint64_t board_state_hash_fields(const BoardState* state)
+{
+    uint64_t hash = zobrist_keys_castling[state->fields & BOARD_STATE_FIELDS_CASTLING];
+    if (board_state_is_white(state))
+        hash ^= zobrist_key_active_color_w;
+    if (state->en_passant_square)
+        hash ^= zobrist_keys_en_passant[__builtin_ctzll(state->en_passant_square) % RANK_SIZE];
+    return hash;
+}
+
+static uint64_t board_state_compute_hash(const BoardState* state)
+{
+    const Bitboard empty = {0};
+    return board_state_hash_pieces_diff(&empty, &state->board) ^ board_state_hash_fields(state);
+}
+
 void board_state_init(BoardState* state)
 {
     state->fields |=
@@ -17,6 +79,7 @@ void board_state_init(BoardState* state)
         | BOARD_STATE_FIELDS_ACTIVE_COLOR_W;
     state->fullmove_count = 1;
     bitboard_set_starting_position(&state->board);
+    state->hash = board_state_compute_hash(state);
 }
 
 void board_state_clear(BoardState* state)
@@ -26,6 +89,7 @@ void board_state_clear(BoardState* state)
     state->halfmove_clock    = 0;
     state->en_passant_square = 0;
     state->fields            = 0;
+    state->hash              = 0;
 }
 
 void board_state_to_fen_string(const BoardState* state, char* str, size_t str_size)
@@ -120,9 +184,8 @@ void board_state_to_fen_string(const BoardState* state, char* str, size_t str_si
     str[idx++] = '\0';
 }
 
-void board_state_set_fen_string(BoardState* state, const char* str, size_t str_size)
+static void board_state_parse_fen_string(BoardState* state, const char* str, size_t str_size)
 {
-    assert(state != NULL);
     board_state_clear(state);
     Bitboard* board = &state->board;
     uint64_t rank_num = RANK_SIZE - 1;
@@ -196,6 +259,13 @@ void board_state_set_fen_string(BoardState* state, const char* str, size_t str_s
     }
 }
 
+void board_state_set_fen_string(BoardState* state, const char* str, size_t str_size)
+{
+    assert(state != NULL);
+    board_state_parse_fen_string(state, str, str_size);
+    state->hash = board_state_compute_hash(state);
+}
+
 void board_state_copy(const BoardState* state, BoardState* other)
 {
     assert(state != NULL);
@@ -210,7 +280,7 @@ void board_state_print(const BoardState* state, const square_t annotation)
     bitboard_to_string_annotated(&state->board, annotation, board_str, BITBOARD_TO_STRING_SIZE);
     char fen_str[BOARD_STATE_TO_FEN_STRING_SIZE];
     board_state_to_fen_string(state, fen_str, BOARD_STATE_TO_FEN_STRING_SIZE);
-    printf("%s\n%s; eval: %.2f\n", board_str, fen_str, (board_state_is_white(state) ? 1.0f : -1.0f) * board_state_evaluate_abs(state));
+    printf("%s\n%s; eval: %.2f\n", board_str, fen_str, (board_state_is_white(state) ? 1 : -1) * board_state_evaluate_abs(state) / 100.0);
 }
 
 bool board_state_is_white(const BoardState* state)
@@ -218,6 +288,13 @@ bool board_state_is_white(const BoardState* state)
     return state->fields & BOARD_STATE_FIELDS_ACTIVE_COLOR_W;   
 }
 
+// kept up to date by every function that changes the position
+uint64_t board_state_get_hash(const BoardState* state)
+{
+    assert(state != NULL);
+    return state->hash;
+}
+
 square_t board_state_get_pseudo_legal_squares_pawns_attacks_no_en_passant(const BoardState* state, bool is_white, square_t selection)
 {
     assert(state != NULL);
@@ -589,6 +666,64 @@ size_t board_state_get_pseudo_legal_moves(const BoardState* state, Move* moves,
     return idx;
 }
 
+// captures, en passant and queen promotions only
+size_t board_state_get_pseudo_legal_captures(const BoardState* state, Move* moves, size_t moves_size)
+{
+    assert(state != NULL);
+    assert(moves != NULL);
+    assert(moves_size >= BOARD_STATE_MOVES_SIZE);
+    const Bitboard* board          = &state->board;
+    const bool is_white            = board_state_is_white(state);
+    const square_t own_pieces      = bitboard_get_all_pieces(board) & (is_white ? board->w : ~board->w);
+    const square_t opponent_pieces = bitboard_get_all_pieces(board) & (is_white ? ~board->w : board->w);
+    const square_t promotion_rank  = is_white ? RANK_8 : RANK_1;
+    // castling never captures, so skip its attack checks
+    BoardState copy = {0};
+    board_state_copy(state, &copy);
+    copy.fields &= ~BOARD_STATE_FIELDS_CASTLING;
+    // pretend the en passant square holds an opponent pawn
+    BoardState copy_en_passant = {0};
+    board_state_copy(state, &copy_en_passant);
+    copy_en_passant.board.p |= state->en_passant_square;
+    if (is_white)
+        copy_en_passant.board.w &= ~state->en_passant_square;
+    else
+        copy_en_passant.board.w |= state->en_passant_square;
+    size_t idx = 0;
+    for (square_t from = 1ULL; from; from <<= 1)
+    {
+        if (!(from & own_pieces))
+            continue;
+        square_t square_moves = 0;
+        if (board->p & from)
+            square_moves =
+                board_state_get_pseudo_legal_squares_pawns_attacks_no_en_passant(&copy_en_passant, is_white, from)
+                | (board_state_get_pseudo_legal_squares_pawns_moves(state, is_white, from) & promotion_rank);
+        else if (board->n & from)
+            square_moves = board_state_get_pseudo_legal_squares_knights(state, is_white, from) & opponent_pieces;
+        else if (board->b & from)
+            square_moves = board_state_get_pseudo_legal_squares_bishops(state, is_white, from) & opponent_pieces;
+        else if (board->r & from)
+            square_moves = board_state_get_pseudo_legal_squares_rooks(state, is_white, from) & opponent_pieces;
+        else if (board->q & from)
+            square_moves = board_state_get_pseudo_legal_squares_queens(state, is_white, from) & opponent_pieces;
+        else if (board->k & from)
+            square_moves = board_state_get_pseudo_legal_squares_kings(&copy, is_white, from) & opponent_pieces;
+        for (square_t to = 1ULL; to; to <<= 1)
+        {
+            if (!(to & square_moves))
+                continue;
+            moves[idx++] = (Move)
+            {
+                .from   = from,
+                .to     = to,
+                .fields = ((board->p & from) && (to & promotion_rank)) ? MOVE_FIELDS_QUEENING_CHOICE_Q : 0
+            };
+        }
+    }
+    return idx;
+}
+
 square_t board_state_get_attacked_kings(const BoardState* state, bool is_white)
 {
     assert(state != NULL);
@@ -609,6 +744,120 @@ square_t board_state_get_attacked_kings(const BoardState* state, bool is_white)
         | moves_kings);
 }
 
+static square_t get_sliding_attacks(square_t square, square_t occupancy, bool is_diagonal)
+{
+    // N E S W, NW NE SW SE
+    const int shifts[2][4] =
+    {
+        { RANK_SIZE, 1, -RANK_SIZE, -1 },
+        { RANK_SIZE - 1, RANK_SIZE + 1, -(RANK_SIZE + 1), -(RANK_SIZE - 1) },
+    };
+    const square_t edges[2][4] =
+    {
+        { RANK_8, FILE_H, RANK_1, FILE_A },
+        { RANK_8|FILE_A, RANK_8|FILE_H, RANK_1|FILE_A, RANK_1|FILE_H },
+    };
+    square_t attacks = 0;
+    for (int direction=0; direction<4; ++direction)
+    {
+        const int shift     = shifts[is_diagonal][direction];
+        const square_t edge = edges[is_diagonal][direction];
+        for (square_t temp = square; !(temp & edge);)
+        {
+            temp = (shift > 0) ? temp << shift : temp >> -shift;
+            attacks |= temp;
+            if (temp & occupancy)
+                break;
+        }
+    }
+    return attacks;
+}
+
+// attackers of both colors, with sliders seeing through squares missing from occupancy
+square_t board_state_get_attackers(const BoardState* state, square_t square, square_t occupancy)
+{
+    assert(state != NULL);
+    assert(is_power_of_two(square));
+    const Bitboard* board = &state->board;
+    const square_t pawns_w = board->p & board->w;
+    const square_t pawns_b = board->p & ~board->w;
+    // a white pawn attacks square from below, a black one from above
+    const square_t attackers_pawns =
+        (pawns_w & (((square & ~FILE_A) >> (RANK_SIZE + 1)) | ((square & ~FILE_H) >> (RANK_SIZE - 1))))
+        | (pawns_b & (((square & ~FILE_A) << (RANK_SIZE - 1)) | ((square & ~FILE_H) << (RANK_SIZE + 1))));
+    const square_t knight_squares =
+        (square   & ~(FILE_A        | RANK_8|RANK_7)) << ((2 * RANK_SIZE) - 1)
+        | (square & ~(FILE_H        | RANK_8|RANK_7)) << ((2 * RANK_SIZE) + 1)
+        | (square & ~(FILE_A|FILE_B | RANK_8       )) << ((1 * RANK_SIZE) - 2)
+        | (square & ~(FILE_G|FILE_H | RANK_8       )) << ((1 * RANK_SIZE) + 2)
+        | (square & ~(FILE_A|FILE_B | RANK_1       )) >> ((1 * RANK_SIZE) + 2)
+        | (square & ~(FILE_G|FILE_H | RANK_1       )) >> ((1 * RANK_SIZE) - 2)
+        | (square & ~(FILE_A        | RANK_1|RANK_2)) >> ((2 * RANK_SIZE) + 1)
+        | (square & ~(FILE_H        | RANK_1|RANK_2)) >> ((2 * RANK_SIZE) - 1);
+    const square_t king_squares =
+        ((square   & (RANK_8|FILE_A)) ? 0 : (square << (RANK_SIZE - 1)))
+        | ((square & (RANK_8       )) ? 0 : (square << (RANK_SIZE)))
+        | ((square & (RANK_8|FILE_H)) ? 0 : (square << (RANK_SIZE + 1)))
+        | ((square & (       FILE_A)) ? 0 : (square >> 1))
+        | ((square & (       FILE_H)) ? 0 : (square << 1))
+        | ((square & (RANK_1|FILE_A)) ? 0 : (square >> (RANK_SIZE + 1)))
+        | ((square & (RANK_1       )) ? 0 : (square >> (RANK_SIZE)))
+        | ((square & (RANK_1|FILE_H)) ? 0 : (square >> (RANK_SIZE - 1)));
+    return occupancy & (
+        attackers_pawns
+        | (knight_squares & board->n)
+        | (king_squares & board->k)
+        | (get_sliding_attacks(square, occupancy, true) & (board->b | board->q))
+        | (get_sliding_attacks(square, occupancy, false) & (board->r | board->q)));
+}
+
+// "SEE - The Swap Algorithm", _Chessprogramming wiki_
+// https://www.chessprogramming.org/SEE_-_The_Swap_Algorithm
+evaluation_t board_state_see(const BoardState* state, const Move* move)
+{
+    assert(state != NULL);
+    assert(move != NULL);
+    const Bitboard* board = &state->board;
+    const bool is_en_passant = (board->p & move->from) && (move->to == state->en_passant_square);
+    evaluation_t gain[32];
+    gain[0] = is_en_passant ? EVALUATION_PAWN : board_state_evaluate_piece(bitboard_get_piece(board, move->to));
+    evaluation_t attacker_value = board_state_evaluate_piece(bitboard_get_piece(board, move->from));
+    if (move->fields & MOVE_FIELDS_QUEENING_CHOICE_Q)
+    {
+        gain[0]       += EVALUATION_QUEEN - EVALUATION_PAWN;
+        attacker_value = EVALUATION_QUEEN;
+    }
+    square_t occupancy = bitboard_get_all_pieces(board) & ~move->from;
+    if (is_en_passant)
+        occupancy &= ~(board_state_is_white(state) ? move->to >> RANK_SIZE : move->to << RANK_SIZE);
+    bool is_white = !board_state_is_white(state);
+    size_t depth  = 0;
+    for (;;)
+    {
+        ++depth;
+        gain[depth] = attacker_value - gain[depth-1];
+        if ((-gain[depth-1] > gain[depth] ? -gain[depth-1] : gain[depth]) < 0 || depth + 1 >= sizeof(gain) / sizeof(gain[0]))
+            break;
+        // recomputing the sliders from occupancy uncovers x-ray attackers
+        const square_t attackers = board_state_get_attackers(state, move->to, occupancy)
+            & (is_white ? board->w : ~board->w);
+        if (!attackers)
+            break;
+        // least valuable attacker first
+        square_t from = 0;
+        const square_t* pieces[] = { &board->p, &board->n, &board->b, &board->r, &board->q, &board->k };
+        for (size_t i=0; i<sizeof(pieces) / sizeof(pieces[0]) && !from; ++i)
+            if (attackers & *pieces[i])
+                from = (attackers & *pieces[i]) & -(attackers & *pieces[i]);
+        attacker_value = board_state_evaluate_piece(bitboard_get_piece(board, from));
+        occupancy     &= ~from;
+        is_white       = !is_white;
+    }
+    while (--depth)
+        gain[depth-1] = -(-gain[depth-1] > gain[depth] ? -gain[depth-1] : gain[depth]);
+    return gain[0];
+}
+
 apply_move_status_t board_state_apply_move(BoardState* state, const Move* move)
 {
     assert(state != NULL);
@@ -619,6 +868,8 @@ apply_move_status_t board_state_apply_move(BoardState* state, const Move* move)
         return APPLY_MOVE_STATUS_ERROR_FROM_PIECE_EMPTY;
     const bool is_white = board_state_is_white(state);
     bool is_capture = bitboard_get_piece_ptr(board, move->to);
+    const Bitboard board_before = *board;
+    const uint64_t hash_fields_before = board_state_hash_fields(state);
     // -- handle move --
     if (from_piece == &board->p)
     {
@@ -715,12 +966,26 @@ apply_move_status_t board_state_apply_move(BoardState* state, const Move* move)
                 : move->to << RANK_SIZE;
         }
     }
+    state->hash ^= board_state_hash_pieces_diff(&board_before, board) ^ hash_fields_before ^ board_state_hash_fields(state);
     // check for king attacks
     return !board_state_get_attacked_kings(state, is_white)
         ? APPLY_MOVE_STATUS_OK
         : APPLY_MOVE_STATUS_ILLEGAL_ANY_KING_ATTACKED;
 }
 
+// pass the turn, only side to move and en passant enter the hash
+void board_state_apply_null_move(BoardState* state)
+{
+    assert(state != NULL);
+    state->hash ^= board_state_hash_fields(state);
+    if (!board_state_is_white(state))
+        state->fullmove_count += 1;
+    state->fields ^= BOARD_STATE_FIELDS_ACTIVE_COLOR_W;
+    state->en_passant_square = 0;
+    ++state->halfmove_clock;
+    state->hash ^= board_state_hash_fields(state);
+}
+
 size_t board_state_get_legal_moves(const BoardState* state, Move* moves, size_t moves_size)
 {
     assert(state != NULL);
@@ -739,50 +1004,76 @@ size_t board_state_get_legal_moves(const BoardState* state, Move* moves, size_t
     return idx;
 }
 
-float board_state_evaluate_piece_count(const BoardState* state)
+evaluation_t board_state_evaluate_piece(piece_t piece)
+{
+    switch (piece)
+    {
+        case PIECE_WP: case PIECE_BP: return EVALUATION_PAWN;
+        case PIECE_WN: case PIECE_BN: return EVALUATION_KNIGHT;
+        case PIECE_WB: case PIECE_BB: return EVALUATION_BISHOP;
+        case PIECE_WR: case PIECE_BR: return EVALUATION_ROOK;
+        case PIECE_WQ: case PIECE_BQ: return EVALUATION_QUEEN;
+        case PIECE_WK: case PIECE_BK: return EVALUATION_KING;
+        default:                      return 0;
+    }
+}
+
+evaluation_t board_state_evaluate_piece_count(const BoardState* state)
 {
     assert(state != NULL);
     #define EVALUATE_PIECE_COUNT(scalar, piece) \
         scalar * (__builtin_popcountll(board->piece & board->w) - __builtin_popcountll(board->piece & ~board->w))
     const Bitboard* board = &state->board;
-    return EVALUATE_PIECE_COUNT(200.0f, k)
-        + EVALUATE_PIECE_COUNT(9.0f, q)
-        + EVALUATE_PIECE_COUNT(5.0f, r)
-        + EVALUATE_PIECE_COUNT(3.0f, b)
-        + EVALUATE_PIECE_COUNT(3.0f, n)
-        + EVALUATE_PIECE_COUNT(1.0f, p);
+    return EVALUATE_PIECE_COUNT(EVALUATION_KING, k)
+        + EVALUATE_PIECE_COUNT(EVALUATION_QUEEN, q)
+        + EVALUATE_PIECE_COUNT(EVALUATION_ROOK, r)
+        + EVALUATE_PIECE_COUNT(EVALUATION_BISHOP, b)
+        + EVALUATE_PIECE_COUNT(EVALUATION_KNIGHT, n)
+        + EVALUATE_PIECE_COUNT(EVALUATION_PAWN, p);
     #undef EVALUATE_PIECE_COUNT
 }
 
 evaluation_t board_state_evaluate_abs(const BoardState* state)
 {
     assert(state != NULL);
-    return (board_state_is_white(state) ? 1.0f : -1.0f) * board_state_evaluate_piece_count(state);
+    return (board_state_is_white(state) ? 1 : -1) * board_state_evaluate_piece_count(state);
 }
 
-evaluation_t board_state_evaluate_minimax(const BoardState* state, uint64_t depth)
+static evaluation_t evaluate_minimax(const BoardState* state, uint64_t depth, uint64_t ply)
 {
-    assert(state != NULL);
     if (depth == 0)
         return board_state_evaluate_abs(state);
     Move moves[BOARD_STATE_MOVES_SIZE];
     const size_t moves_size = board_state_get_legal_moves(state, moves, BOARD_STATE_MOVES_SIZE);
     if (moves_size == 0)
-        return -INFINITY;
-    evaluation_t max_evaluation = -INFINITY;
+        return board_state_get_attacked_kings(state, board_state_is_white(state))
+            ? -(EVALUATION_MATE - (evaluation_t)ply)
+            : EVALUATION_DRAW;
+    evaluation_t max_evaluation = -EVALUATION_INFINITE;
     for (size_t i=0; i<moves_size; ++i)
     {
         const Move* move = &moves[i];
         BoardState copy  = {0};
         board_state_copy(state, &copy);
         board_state_apply_move(&copy, move);
-        const evaluation_t evaluation = -board_state_evaluate_minimax(&copy, depth - 1);
+        const evaluation_t evaluation = -evaluate_minimax(&copy, depth - 1, ply + 1);
         if (evaluation > max_evaluation)
             max_evaluation = evaluation;
     }
     return max_evaluation;
 }
 
+evaluation_t board_state_evaluate_minimax(const BoardState* state, uint64_t depth)
+{
+    assert(state != NULL);
+    return evaluate_minimax(state, depth, 0);
+}
+
+bool evaluation_is_mate(evaluation_t evaluation)
+{
+    return evaluation >= EVALUATION_MATE_BOUND || evaluation <= -EVALUATION_MATE_BOUND;
+}
+
 void move_to_string(const Move* move, char* str, size_t str_size)
 {
     assert(move != NULL);
@@ -827,3 +1118,33 @@ Move string_to_move(const char* str, size_t str_size)
     };
 } 
 
+// 16 bits: from (6) | to (6) | queening choice (4)
+uint16_t move_to_packed(const Move* move)
+{
+    assert(move != NULL);
+    if (!move->from || !move->to)
+        return MOVE_PACKED_NONE;
+    return (uint16_t)__builtin_ctzll(move->from)
+        | (uint16_t)__builtin_ctzll(move->to) << 6
+        | (uint16_t)(move->fields & 0xF) << 12;
+}
+
+Move packed_to_move(uint16_t packed)
+{
+    if (packed == MOVE_PACKED_NONE)
+        return (Move){0};
+    return (Move)
+    {
+        .from   = 1ULL << (packed & 0x3F),
+        .to     = 1ULL << ((packed >> 6) & 0x3F),
+        .fields = (packed >> 12) & 0xF
+    };
+}
+
+bool move_is_equal(const Move* a, const Move* b)
+{
+    assert(a != NULL);
+    assert(b != NULL);
+    return a->from == b->from && a->to == b->to && a->fields == b->fields;
+}
+
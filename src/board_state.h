@@ -15,6 +15,8 @@ typedef struct
     uint64_t halfmove_clock;
     square_t en_passant_square;
     uint8_t fields;
+    // zobrist key, updated incrementally
+    uint64_t hash;
 } BoardState;
 
 typedef struct
@@ -30,7 +32,8 @@ typedef enum
     APPLY_MOVE_STATUS_ILLEGAL_ANY_KING_ATTACKED,
 } apply_move_status_t;
 
-typedef float evaluation_t;
+// centipawns from the side to move
+typedef int32_t evaluation_t;
 
 #define BOARD_STATE_TO_FEN_STRING_SIZE (\
     BOARD_SIZE + (FILE_SIZE-1) /* board */ \
@@ -46,6 +49,7 @@ typedef float evaluation_t;
 
 #define MOVE_TO_STRING_SIZE (2 * SQUARE_TO_STRING_SIZE + 2)
 #define STRING_TO_MOVE_SIZE 4
+#define MOVE_PACKED_NONE 0
 
 static const uint8_t BOARD_STATE_FIELDS_CASTLING_WQ    = 1ULL << 0;
 static const uint8_t BOARD_STATE_FIELDS_CASTLING_WK    = 1ULL << 1;
@@ -61,6 +65,20 @@ static const uint8_t MOVE_FIELDS_QUEENING_CHOICE_N = 1ULL << 3;
 
 static const uint64_t CASTLING_DISTANCE = 2ULL;
 
+static const evaluation_t EVALUATION_PAWN   = 100;
+static const evaluation_t EVALUATION_KNIGHT = 300;
+static const evaluation_t EVALUATION_BISHOP = 300;
+static const evaluation_t EVALUATION_ROOK   = 500;
+static const evaluation_t EVALUATION_QUEEN  = 900;
+static const evaluation_t EVALUATION_KING   = 20000;
+
+// being mated at ply scores -(EVALUATION_MATE - ply), so shorter mates score higher.
+// everything beyond EVALUATION_MATE_BOUND is a forced mate, and all of it fits in 16 bits
+static const evaluation_t EVALUATION_DRAW       = 0;
+static const evaluation_t EVALUATION_MATE       = 32000;
+static const evaluation_t EVALUATION_MATE_BOUND = 31000;
+static const evaluation_t EVALUATION_INFINITE   = 32001;
+
 void board_state_init(BoardState* state);
 void board_state_clear(BoardState* state);
 void board_state_to_fen_string(const BoardState* state, char* str, size_t str_size);
@@ -68,6 +86,7 @@ void board_state_set_fen_string(BoardState* state, const char* str, size_t str_s
 void board_state_copy(const BoardState* state, BoardState* other);
 void board_state_print(const BoardState* state, const square_t annotation);
 bool board_state_is_white(const BoardState* state);
+uint64_t board_state_get_hash(const BoardState* state);
 
 square_t board_state_get_pseudo_legal_squares_pawns_attacks_no_en_passant(const BoardState* state, bool is_white, square_t selection);
 square_t board_state_get_pseudo_legal_squares_pawns_moves(const BoardState* state, bool is_white, square_t selection);
@@ -85,18 +104,27 @@ size_t board_state_get_pseudo_legal_moves_queens(const BoardState* state, Move*
 size_t board_state_get_pseudo_legal_moves_kings(const BoardState* state, Move* moves, size_t moves_size);
 
 size_t board_state_get_pseudo_legal_moves(const BoardState* state, Move* moves, size_t moves_size);
+size_t board_state_get_pseudo_legal_captures(const BoardState* state, Move* moves, size_t moves_size);
 
 square_t board_state_get_attacked_kings(const BoardState* state, bool is_white);
+square_t board_state_get_attackers(const BoardState* state, square_t square, square_t occupancy);
+evaluation_t board_state_see(const BoardState* state, const Move* move);
 apply_move_status_t board_state_apply_move(BoardState* state, const Move* move);
+void board_state_apply_null_move(BoardState* state);
 
 size_t board_state_get_legal_moves(const BoardState* state, Move* moves, size_t moves_size);
 
+evaluation_t board_state_evaluate_piece(piece_t piece);
 evaluation_t board_state_evaluate_piece_count(const BoardState* state);
 evaluation_t board_state_evaluate_abs(const BoardState* state);
 evaluation_t board_state_evaluate_minimax(const BoardState* state, uint64_t depth);
+bool evaluation_is_mate(evaluation_t evaluation);
 
 void move_to_string(const Move* move, char* str, size_t str_size);
 Move string_to_move(const char* str, size_t str_size);
+uint16_t move_to_packed(const Move* move);
+Move packed_to_move(uint16_t packed);
+bool move_is_equal(const Move* a, const Move* b);
 
 #endif // BOARD_STATE_H
 
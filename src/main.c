@@ -7,6 +7,8 @@
 #include "bitboard.h"
 #include "board_state.h"
 #include "perft.h"
+#include "bench.h"
+#include "search.h"
 #include "uci.h"
 #include "utils.h"
 #include "dyn_array.h"
@@ -16,6 +18,10 @@
     "  perft <depth> <move>*    Run perft depth after applying moves to starting position.\n" \
     "  fen <move>*              Generate fen string after applying moves to starting position.\n" \
     "  perft-fen <fen> <move>*  Run perft depth after applying moves to fen position.\n" \
+    "  bench <depth>            Search the bench positions and report node counts.\n" \
+    "  bench-mtdf <depth>       Compare MTD(f) against PVS, with and without pruning.\n" \
+    "  bench-verify <depth>     Compare alpha-beta against minimax on the bench positions.\n" \
+    "  bench-smp <depth>        Report time to depth for 1 to 16 search threads.\n" \
     "  uci                      Start UCI mode.\n"
 
 #define CNOOBDOGG_TYPE_HELP "Type 'help' for more information.\n"
@@ -26,11 +32,16 @@
 void handle_fen(char** tokens, size_t tokens_size);
 void handle_perft(char** tokens, size_t tokens_size);
 void handle_perft_fen(char** tokens, size_t tokens_size);
+void handle_bench(char** tokens, size_t tokens_size);
+void handle_bench_mtdf(char** tokens, size_t tokens_size);
+void handle_bench_verify(char** tokens, size_t tokens_size);
+void handle_bench_smp(char** tokens, size_t tokens_size);
 
 int main(void)
 {
     setvbuf(stdout, NULL, _IONBF, 0);
     setvbuf(stdin, NULL, _IONBF, 0);
+    search_init();
     printf("%s\n", UCI_CNOOBDOGG_NAME);
     for (;;)
     {
@@ -57,6 +68,14 @@ int main(void)
             handle_perft(tokens.data + 1, tokens.size - 1);
         else if (strcmp(cmd, "perft-fen") == 0)
             handle_perft_fen(tokens.data + 1, tokens.size - 1);
+        else if (strcmp(cmd, "bench") == 0)
+            handle_bench(tokens.data + 1, tokens.size - 1);
+        else if (strcmp(cmd, "bench-mtdf") == 0)
+            handle_bench_mtdf(tokens.data + 1, tokens.size - 1);
+        else if (strcmp(cmd, "bench-verify") == 0)
+            handle_bench_verify(tokens.data + 1, tokens.size - 1);
+        else if (strcmp(cmd, "bench-smp") == 0)
+            handle_bench_smp(tokens.data + 1, tokens.size - 1);
         else if (strcmp(cmd, "uci") == 0)
             uci_run_dialog();
         else
@@ -145,3 +164,51 @@ void handle_perft_fen(char** tokens, size_t tokens_size)
     free(moves);
 }
 
+void handle_bench(char** tokens, size_t tokens_size)
+{
+    assert(tokens != NULL);
+    if (tokens_size < 1)
+    {
+        printf("Please provide a depth. " CNOOBDOGG_TYPE_HELP);
+        return;
+    }
+    const uint64_t depth = atoi(tokens[0]);
+    bench_search(depth);
+}
+
+void handle_bench_verify(char** tokens, size_t tokens_size)
+{
+    assert(tokens != NULL);
+    if (tokens_size < 1)
+    {
+        printf("Please provide a depth. " CNOOBDOGG_TYPE_HELP);
+        return;
+    }
+    const uint64_t depth = atoi(tokens[0]);
+    bench_search_verify(depth);
+}
+
+void handle_bench_mtdf(char** tokens, size_t tokens_size)
+{
+    assert(tokens != NULL);
+    if (tokens_size < 1)
+    {
+        printf("Please provide a depth. " CNOOBDOGG_TYPE_HELP);
+        return;
+    }
+    const uint64_t depth = atoi(tokens[0]);
+    bench_search_mtdf(depth);
+}
+
+void handle_bench_smp(char** tokens, size_t tokens_size)
+{
+    assert(tokens != NULL);
+    if (tokens_size < 1)
+    {
+        printf("Please provide a depth. " CNOOBDOGG_TYPE_HELP);
+        return;
+    }
+    const uint64_t depth = atoi(tokens[0]);
+    bench_search_smp(depth);
+}
+
@@ -0,0 +1,331 @@
+#include "mcts.h"
+
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "time_manager.h"
+
+// a selected leaf, with the path to it still carrying its virtual loss
+typedef struct
+{
+    BoardState state;
+    uint32_t path[SEARCH_DEPTH_MAX + 1];
+    size_t path_size;
+} MctsLeaf;
+
+// cheap priors from the move ordering ideas of the alpha-beta search: good captures and queening first
+static double mcts_prior_weight(const BoardState* state, const Move* move)
+{
+    double weight = 1.0;
+    if (bitboard_get_piece(&state->board, move->to) != PIECE_NONE)
+    {
+        const evaluation_t see = board_state_see(state, move);
+        weight = (see >= 0) ? 2.0 + (double)see / EVALUATION_PAWN : 0.5;
+    }
+    if (move->fields & MOVE_FIELDS_QUEENING_CHOICE_Q)
+        weight += 4.0;
+    return weight;
+}
+
+static double mcts_score_to_value(evaluation_t score)
+{
+    return score / (fabs((double)score) + MCTS_CENTIPAWNS_HALF);
+}
+
+// the inverse, kept clear of the mate scores since a sure win proves no mate distance
+static evaluation_t mcts_value_to_score(double value)
+{
+    const double limit = EVALUATION_MATE_BOUND - 1;
+    const double score = (fabs(value) < 1.0) ? MCTS_CENTIPAWNS_HALF * value / (1.0 - fabs(value)) : limit;
+    if (score > limit)
+        return (evaluation_t)limit;
+    if (score < -limit)
+        return (evaluation_t)-limit;
+    return (evaluation_t)score;
+}
+
+static bool mcts_is_expanded(const simp_tree_mcts_node* node)
+{
+    return __atomic_load_n(&node->data.state, __ATOMIC_ACQUIRE) == MCTS_NODE_STATE_EXPANDED && node->children_size > 0;
+}
+
+// PUCT: the average value plus an exploration bonus, led by the prior and fading with visits
+static uint32_t mcts_select_child(const simp_tree_mcts* tree, uint32_t index, double exploration)
+{
+    const simp_tree_mcts_node* node = &tree->nodes[index];
+    const double parent_visits = __atomic_load_n(&node->data.visits, __ATOMIC_RELAXED)
+        + __atomic_load_n(&node->data.virtual_loss, __ATOMIC_RELAXED);
+    const double sqrt_visits = sqrt(parent_visits + 1.0);
+    uint32_t best     = node->first_child;
+    double best_score = -DBL_MAX;
+    for (uint32_t i=0; i<node->children_size; ++i)
+    {
+        const MctsNode* child = &tree->nodes[node->first_child + i].data;
+        const int32_t virtual_loss = __atomic_load_n(&child->virtual_loss, __ATOMIC_RELAXED);
+        const double visits = __atomic_load_n(&child->visits, __ATOMIC_RELAXED) + virtual_loss;
+        const double value  = (double)__atomic_load_n(&child->value_sum, __ATOMIC_RELAXED) / MCTS_VALUE_SCALE;
+        // a virtual loss counts as a lost playout, steering the other threads elsewhere
+        const double q = (visits > 0) ? (value - virtual_loss) / visits : 0.0;
+        const double u = exploration * child->prior * sqrt_visits / (1.0 + visits);
+        if (q + u > best_score)
+        {
+            best       = node->first_child + i;
+            best_score = q + u;
+        }
+    }
+    return best;
+}
+
+static uint32_t mcts_get_best_child(const simp_tree_mcts* tree, uint32_t index)
+{
+    const simp_tree_mcts_node* node = &tree->nodes[index];
+    uint32_t best        = SIMP_TREE_NONE;
+    uint32_t best_visits = 0;
+    for (uint32_t i=0; i<node->children_size; ++i)
+    {
+        const uint32_t visits = __atomic_load_n(&tree->nodes[node->first_child + i].data.visits, __ATOMIC_RELAXED);
+        if (visits > best_visits)
+        {
+            best        = node->first_child + i;
+            best_visits = visits;
+        }
+    }
+    return best;
+}
+
+static void mcts_select(simp_tree_mcts* tree, const BoardState* state, MctsLeaf* leaf, double exploration)
+{
+    board_state_copy(state, &leaf->state);
+    uint32_t index  = 0;
+    leaf->path[0]   = index;
+    leaf->path_size = 1;
+    __atomic_fetch_add(&tree->nodes[index].data.virtual_loss, 1, __ATOMIC_RELAXED);
+    while (leaf->path_size - 1 < SEARCH_DEPTH_MAX && mcts_is_expanded(&tree->nodes[index]))
+    {
+        index = mcts_select_child(tree, index, exploration);
+        board_state_apply_move(&leaf->state, &tree->nodes[index].data.move);
+        __atomic_fetch_add(&tree->nodes[index].data.virtual_loss, 1, __ATOMIC_RELAXED);
+        leaf->path[leaf->path_size++] = index;
+    }
+}
+
+// the children are written before the node is published as expanded
+static void mcts_expand(simp_tree_mcts* tree, uint32_t index, const BoardState* state, const Move* moves, size_t moves_size)
+{
+    const uint32_t first_child = simp_tree_mcts_reserve(tree, moves_size);
+    if (first_child == SIMP_TREE_NONE)
+    {
+        __atomic_store_n(&tree->nodes[index].data.state, MCTS_NODE_STATE_LEAF, __ATOMIC_RELEASE);
+        return;
+    }
+    double weights[BOARD_STATE_MOVES_SIZE];
+    double weights_sum = 0;
+    for (size_t i=0; i<moves_size; ++i)
+    {
+        weights[i]   = mcts_prior_weight(state, &moves[i]);
+        weights_sum += weights[i];
+    }
+    for (size_t i=0; i<moves_size; ++i)
+    {
+        simp_tree_mcts_node* child = &tree->nodes[first_child + i];
+        child->data          = (MctsNode){ .move = moves[i], .state = MCTS_NODE_STATE_LEAF, .prior = (float)(weights[i] / weights_sum) };
+        child->parent        = index;
+        child->first_child   = 0;
+        child->children_size = 0;
+    }
+    tree->nodes[index].first_child   = first_child;
+    tree->nodes[index].children_size = (uint16_t)moves_size;
+    __atomic_store_n(&tree->nodes[index].data.state, MCTS_NODE_STATE_EXPANDED, __ATOMIC_RELEASE);
+}
+
+// two leaves of one batch ending on the same node would evaluate it twice, unless it is terminal
+static bool mcts_is_in_batch(const simp_tree_mcts* tree, const MctsLeaf* leaves, size_t leaves_size, const MctsLeaf* leaf)
+{
+    const uint32_t index = leaf->path[leaf->path_size - 1];
+    if (__atomic_load_n(&tree->nodes[index].data.state, __ATOMIC_RELAXED) == MCTS_NODE_STATE_TERMINAL)
+        return false;
+    for (size_t i=0; i<leaves_size; ++i)
+        if (leaves[i].path[leaves[i].path_size - 1] == index)
+            return true;
+    return false;
+}
+
+// only the thread that expands a leaf evaluates it with a quiescence search, anyone arriving
+// later collided with it and gets false; the value is from the view of the side to move at the leaf
+static bool mcts_evaluate(SearchThread* thread, simp_tree_mcts* tree, const MctsLeaf* leaf, double* value)
+{
+    const uint64_t ply    = leaf->path_size - 1;
+    const uint32_t index  = leaf->path[ply];
+    Move moves[BOARD_STATE_MOVES_SIZE];
+    const bool is_terminal = __atomic_load_n(&tree->nodes[index].data.state, __ATOMIC_RELAXED) == MCTS_NODE_STATE_TERMINAL;
+    const size_t moves_size = is_terminal ? 0 : board_state_get_legal_moves(&leaf->state, moves, BOARD_STATE_MOVES_SIZE);
+    if (moves_size == 0)
+    {
+        __atomic_store_n(&tree->nodes[index].data.state, MCTS_NODE_STATE_TERMINAL, __ATOMIC_RELAXED);
+        // no quiescence search counts this node, but node limits still have to see it
+        search_count_nodes(thread, 1);
+        *value = board_state_get_attacked_kings(&leaf->state, board_state_is_white(&leaf->state)) ? -1.0 : 0.0;
+        return true;
+    }
+    // too deep to expand, so it stays a leaf for everyone
+    if (ply < SEARCH_DEPTH_MAX)
+    {
+        uint8_t expected = MCTS_NODE_STATE_LEAF;
+        if (!__atomic_compare_exchange_n(&tree->nodes[index].data.state, &expected, MCTS_NODE_STATE_EXPANDING,
+                false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            return false;
+        mcts_expand(tree, index, &leaf->state, moves, moves_size);
+    }
+    const evaluation_t score = search_quiescence(thread, &leaf->state, -EVALUATION_INFINITE, EVALUATION_INFINITE, ply);
+    *value = mcts_score_to_value(score);
+    return true;
+}
+
+// every node keeps the value from the view of the side that moved into it
+static void mcts_backpropagate(simp_tree_mcts* tree, const MctsLeaf* leaf, double value, bool is_counted)
+{
+    for (size_t i=leaf->path_size; i-- > 0;)
+    {
+        value = -value;
+        MctsNode* data = &tree->nodes[leaf->path[i]].data;
+        if (is_counted)
+        {
+            __atomic_fetch_add(&data->visits, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&data->value_sum, (int64_t)(value * MCTS_VALUE_SCALE), __ATOMIC_RELAXED);
+        }
+        __atomic_fetch_sub(&data->virtual_loss, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// the line ends in mate or stalemate, so it cannot get any longer
+static bool mcts_is_pv_final(const BoardState* state, const Move* pv, size_t pv_size)
+{
+    BoardState copy = {0};
+    board_state_copy(state, &copy);
+    for (size_t i=0; i<pv_size; ++i)
+        board_state_apply_move(&copy, &pv[i]);
+    Move moves[BOARD_STATE_MOVES_SIZE];
+    return board_state_get_legal_moves(&copy, moves, BOARD_STATE_MOVES_SIZE) == 0;
+}
+
+// the arena is allocated in full and never grows, the tree stops growing once it is full
+void mcts_alloc(simp_tree_mcts* tree, size_t size_mb)
+{
+    assert(tree != NULL);
+    simp_tree_mcts_alloc(tree, (size_mb << 20) / sizeof(simp_tree_mcts_node));
+}
+
+// called while the pool is idle
+void mcts_new_search(simp_tree_mcts* tree)
+{
+    assert(tree != NULL);
+    simp_tree_mcts_clear(tree);
+    const uint32_t root = simp_tree_mcts_reserve(tree, 1);
+    assert(root == 0);
+    tree->nodes[root].data          = (MctsNode){ .state = MCTS_NODE_STATE_LEAF, .prior = 1.0f };
+    tree->nodes[root].parent        = SIMP_TREE_NONE;
+    tree->nodes[root].first_child   = 0;
+    tree->nodes[root].children_size = 0;
+}
+
+// the most visited line becomes the thread's only line, its length stands in for the depth
+static void mcts_update_line(SearchThread* thread, const simp_tree_mcts* tree, const Move* pv, size_t pv_size, Move* bestmove)
+{
+    const MctsNode* data  = &tree->nodes[mcts_get_best_child(tree, 0)].data;
+    const uint32_t visits = __atomic_load_n(&data->visits, __ATOMIC_RELAXED);
+    const double value    = (double)__atomic_load_n(&data->value_sum, __ATOMIC_RELAXED) / MCTS_VALUE_SCALE;
+    SearchLine* line = &thread->lines[0];
+    memcpy(line->pv, pv, pv_size * sizeof(Move));
+    line->pv_size      = pv_size;
+    line->move         = pv[0];
+    line->score        = mcts_value_to_score(visits ? value / visits : 0.0);
+    thread->lines_size = 1;
+    thread->bestmove   = line->move;
+    thread->score      = line->score;
+    if (pv_size > thread->depth)
+        thread->depth = pv_size;
+    if (bestmove)
+        *bestmove = thread->bestmove;
+    if (thread->on_iteration)
+        thread->on_iteration(thread->on_iteration_arg, thread);
+}
+
+// every thread of the pool runs this on the same tree; the main thread reports whenever the most
+// visited line gets longer, and once more at the end if its first move changed since
+evaluation_t mcts_search(SearchThread* thread, simp_tree_mcts* tree, const BoardState* state, Move* bestmove)
+{
+    assert(thread != NULL);
+    assert(tree != NULL);
+    assert(state != NULL);
+    if (!thread->is_clock_started)
+        search_start_clock(thread);
+    size_t batch_size = (thread->params.mcts_batch_size > 0) ? thread->params.mcts_batch_size : 1;
+    if (batch_size > MCTS_BATCH_SIZE_MAX)
+        batch_size = MCTS_BATCH_SIZE_MAX;
+    MctsLeaf leaves[MCTS_BATCH_SIZE_MAX];
+    Move pv[SEARCH_DEPTH_MAX + 1];
+    size_t pv_size = 0;
+    while (!search_is_aborted(thread))
+    {
+        // select the whole batch first, the virtual losses spread it over the tree.
+        // collisions only give their virtual loss back, they are no visits
+        size_t leaves_size = 0;
+        for (size_t i=0; i<batch_size; ++i)
+        {
+            MctsLeaf* leaf = &leaves[leaves_size];
+            mcts_select(tree, state, leaf, thread->params.mcts_exploration);
+            if (mcts_is_in_batch(tree, leaves, leaves_size, leaf))
+                mcts_backpropagate(tree, leaf, 0.0, false);
+            else
+                ++leaves_size;
+        }
+        for (size_t i=0; i<leaves_size; ++i)
+        {
+            double value = 0.0;
+            const bool is_evaluated = !thread->is_aborted && mcts_evaluate(thread, tree, &leaves[i], &value);
+            const bool is_counted   = is_evaluated && !thread->is_aborted;
+            mcts_backpropagate(tree, &leaves[i], value, is_counted);
+            if (is_counted)
+                __atomic_store_n(&thread->stats.playouts, thread->stats.playouts + 1, __ATOMIC_RELAXED);
+        }
+        if (thread->is_aborted)
+            break;
+        pv_size = mcts_get_pv(tree, pv, SEARCH_DEPTH_MAX + 1);
+        if (pv_size > thread->depth)
+            mcts_update_line(thread, tree, pv, pv_size, bestmove);
+        if (thread->limits.depth && (thread->depth >= thread->limits.depth || mcts_is_pv_final(state, pv, pv_size)))
+            break;
+        if (!search_is_pondering(thread) && time_manager_is_soft_expired(&thread->time_manager))
+            break;
+    }
+    pv_size = mcts_get_pv(tree, pv, SEARCH_DEPTH_MAX + 1);
+    if (pv_size > 0 && !move_is_equal(&pv[0], &thread->bestmove))
+        mcts_update_line(thread, tree, pv, pv_size, bestmove);
+    return thread->score;
+}
+
+// follows the most visited child, which is also the move to play at the root
+size_t mcts_get_pv(const simp_tree_mcts* tree, Move* pv, size_t pv_capacity)
+{
+    assert(tree != NULL);
+    assert(pv != NULL);
+    size_t pv_size = 0;
+    uint32_t index = 0;
+    while (pv_size < pv_capacity && simp_tree_mcts_size(tree) > 0 && mcts_is_expanded(&tree->nodes[index]))
+    {
+        index = mcts_get_best_child(tree, index);
+        if (index == SIMP_TREE_NONE)
+            break;
+        pv[pv_size++] = tree->nodes[index].data.move;
+    }
+    return pv_size;
+}
+
+size_t mcts_get_memory(const simp_tree_mcts* tree)
+{
+    assert(tree != NULL);
+    return simp_tree_mcts_size(tree) * sizeof(simp_tree_mcts_node);
+}
+
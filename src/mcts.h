@@ -0,0 +1,54 @@
+#ifndef MCTS_H
+#define MCTS_H
+
+// "Monte-Carlo Tree Search", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Monte-Carlo_Tree_Search
+// Rosin, _Multi-armed bandits with episode context_
+// https://doi.org/10.1007/s10472-011-9258-6
+// Chaslot, Winands, van den Herik, _Parallel Monte-Carlo Tree Search_
+// https://doi.org/10.1007/978-3-540-87608-3_6
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "board_state.h"
+#include "search.h"
+#include "simp_tree.h"
+
+typedef enum
+{
+    MCTS_NODE_STATE_LEAF,
+    MCTS_NODE_STATE_EXPANDING,
+    MCTS_NODE_STATE_EXPANDED,
+    // mate or stalemate, its value is exact and it may be visited any number of times
+    MCTS_NODE_STATE_TERMINAL,
+} mcts_node_state_t;
+
+// everything but move and prior is updated by several threads at once, with relaxed atomics
+typedef struct
+{
+    Move move;
+    uint8_t state;
+    float prior;
+    uint32_t visits;
+    int32_t virtual_loss;
+    // from the view of the side that played move, in thousandths
+    int64_t value_sum;
+} MctsNode;
+
+DEFINE_SIMP_TREE(MctsNode, simp_tree_mcts)
+
+#define MCTS_VALUE_SCALE 1000
+// a score of this many centipawns is worth half a win
+#define MCTS_CENTIPAWNS_HALF 400
+#define MCTS_BATCH_SIZE_MAX 64
+
+void mcts_alloc(simp_tree_mcts* tree, size_t size_mb);
+void mcts_new_search(simp_tree_mcts* tree);
+evaluation_t mcts_search(SearchThread* thread, simp_tree_mcts* tree, const BoardState* state, Move* bestmove);
+size_t mcts_get_pv(const simp_tree_mcts* tree, Move* pv, size_t pv_capacity);
+size_t mcts_get_memory(const simp_tree_mcts* tree);
+
+#endif // MCTS_H
+
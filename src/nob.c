@@ -17,11 +17,19 @@ int main(int argc, char** argv)
         SRC_FOLDER "piece.c",
         SRC_FOLDER "bitboard.c",
         SRC_FOLDER "board_state.c",
+        SRC_FOLDER "transposition_table.c",
+        SRC_FOLDER "time_manager.c",
+        SRC_FOLDER "search.c",
+        SRC_FOLDER "proof_number_search.c",
+        SRC_FOLDER "mcts.c",
+        SRC_FOLDER "search_pool.c",
         SRC_FOLDER "uci.c",
         SRC_FOLDER "perft.c",
+        SRC_FOLDER "bench.c",
         SRC_FOLDER "main.c",
         "-o",
-        BUILD_FOLDER "cnoobdogg");
+        BUILD_FOLDER "cnoobdogg",
+        "-lm");
     if (!nob_cmd_run_sync(cmd)) return 1;
     return 0;
 }
@@ -0,0 +1,221 @@
+#include "proof_number_search.h"
+
+#include <assert.h>
+
+static uint32_t proof_number_add(uint32_t a, uint32_t b)
+{
+    return (a >= PROOF_NUMBER_INFINITE - b) ? PROOF_NUMBER_INFINITE : a + b;
+}
+
+static bool proof_number_search_is_stopped(const ProofNumberSearch* pns)
+{
+    return pns->stop && pns->stop(pns->arg);
+}
+
+// a position is scored when it is created: mates and stalemates are final, so is running out of plies,
+// everything else starts with its mobility, the more replies the harder to prove or disprove
+static ProofNumberNode proof_number_search_new_node(const BoardState* state, const Move* move, uint32_t parent, uint64_t ply, uint64_t plies)
+{
+    ProofNumberNode node = {0};
+    node.move   = *move;
+    node.parent = parent;
+    // the attacker moves on even plies
+    node.is_or  = ply % 2 == 0;
+    Move moves[BOARD_STATE_MOVES_SIZE];
+    const size_t moves_size = board_state_get_legal_moves(state, moves, BOARD_STATE_MOVES_SIZE);
+    const bool is_proven = moves_size == 0
+        && !node.is_or
+        && board_state_get_attacked_kings(state, board_state_is_white(state));
+    if (is_proven)
+    {
+        node.proof    = 0;
+        node.disproof = PROOF_NUMBER_INFINITE;
+    }
+    else if (moves_size == 0 || ply >= plies)
+    {
+        node.proof    = PROOF_NUMBER_INFINITE;
+        node.disproof = 0;
+    }
+    else
+    {
+        node.proof    = node.is_or ? 1 : (uint32_t)moves_size;
+        node.disproof = node.is_or ? (uint32_t)moves_size : 1;
+    }
+    return node;
+}
+
+static void proof_number_search_expand(ProofNumberSearch* pns, uint32_t index, const BoardState* state, uint64_t ply, uint64_t plies)
+{
+    Move moves[BOARD_STATE_MOVES_SIZE];
+    const size_t moves_size = board_state_get_legal_moves(state, moves, BOARD_STATE_MOVES_SIZE);
+    const uint32_t first_child = (uint32_t)pns->nodes.size;
+    // grow by hand, doubling past nodes_max would overshoot the memory limit
+    if (pns->nodes.size + moves_size > pns->nodes.capacity)
+    {
+        const size_t capacity = 2 * pns->nodes.capacity;
+        dyn_array_proof_number_node_realloc(&pns->nodes, (capacity < pns->nodes_max) ? capacity : pns->nodes_max);
+    }
+    for (size_t i=0; i<moves_size; ++i)
+    {
+        BoardState copy = {0};
+        board_state_copy(state, &copy);
+        board_state_apply_move(&copy, &moves[i]);
+        dyn_array_proof_number_node_append(&pns->nodes, proof_number_search_new_node(&copy, &moves[i], index, ply + 1, plies));
+    }
+    // appending may have moved the array
+    ProofNumberNode* node = &pns->nodes.data[index];
+    node->first_child   = first_child;
+    node->children_size = (uint16_t)moves_size;
+    node->is_expanded   = true;
+    if (pns->count)
+        pns->count(pns->arg, moves_size);
+}
+
+// an or node needs one proven child, an and node needs all of them
+static void proof_number_search_update(ProofNumberSearch* pns, uint32_t index)
+{
+    for (;;)
+    {
+        ProofNumberNode* node = &pns->nodes.data[index];
+        uint32_t proof    = node->is_or ? PROOF_NUMBER_INFINITE : 0;
+        uint32_t disproof = node->is_or ? 0 : PROOF_NUMBER_INFINITE;
+        for (uint32_t i=0; i<node->children_size; ++i)
+        {
+            const ProofNumberNode* child = &pns->nodes.data[node->first_child + i];
+            if (node->is_or)
+            {
+                if (child->proof < proof)
+                    proof = child->proof;
+                disproof = proof_number_add(disproof, child->disproof);
+            }
+            else
+            {
+                proof = proof_number_add(proof, child->proof);
+                if (child->disproof < disproof)
+                    disproof = child->disproof;
+            }
+        }
+        node->proof    = proof;
+        node->disproof = disproof;
+        if (index == 0)
+            break;
+        index = node->parent;
+    }
+}
+
+// the attacker goes for the shortest mate, the defender for the longest
+static uint32_t proof_number_search_set_mate_plies(ProofNumberSearch* pns, uint32_t index)
+{
+    ProofNumberNode* node = &pns->nodes.data[index];
+    uint32_t mate_plies = 0;
+    if (node->is_expanded)
+    {
+        mate_plies = node->is_or ? PROOF_NUMBER_INFINITE : 0;
+        for (uint32_t i=0; i<node->children_size; ++i)
+        {
+            const uint32_t child_index = node->first_child + i;
+            if (pns->nodes.data[child_index].proof != 0)
+                continue;
+            const uint32_t child_plies = proof_number_search_set_mate_plies(pns, child_index) + 1;
+            if (node->is_or ? child_plies < mate_plies : child_plies > mate_plies)
+                mate_plies = child_plies;
+        }
+    }
+    pns->nodes.data[index].mate_plies = mate_plies;
+    return mate_plies;
+}
+
+void proof_number_search_alloc(ProofNumberSearch* pns, size_t size_mb, proof_number_search_stop_t stop, proof_number_search_count_t count, void* arg)
+{
+    assert(pns != NULL);
+    pns->nodes_max = (size_mb << 20) / sizeof(ProofNumberNode);
+    assert(pns->nodes_max >= PROOF_NUMBER_NODES_CAPACITY);
+    dyn_array_proof_number_node_alloc(&pns->nodes, PROOF_NUMBER_NODES_CAPACITY);
+    pns->stop  = stop;
+    pns->count = count;
+    pns->arg   = arg;
+}
+
+void proof_number_search_free(ProofNumberSearch* pns)
+{
+    assert(pns != NULL);
+    dyn_array_proof_number_node_free(&pns->nodes);
+}
+
+// best-first: always expand the most proving leaf, then back its numbers up to the root
+bool proof_number_search_prove(ProofNumberSearch* pns, const BoardState* state, uint64_t plies)
+{
+    assert(pns != NULL);
+    assert(state != NULL);
+    pns->nodes.size = 0;
+    dyn_array_proof_number_node_append(&pns->nodes, proof_number_search_new_node(state, &(Move){0}, 0, 0, plies));
+    while (pns->nodes.data[0].proof != 0 && pns->nodes.data[0].disproof != 0)
+    {
+        if (proof_number_search_is_stopped(pns) || pns->nodes.size + BOARD_STATE_MOVES_SIZE > pns->nodes_max)
+            return false;
+        BoardState current = {0};
+        board_state_copy(state, &current);
+        uint32_t index = 0;
+        uint64_t ply   = 0;
+        while (pns->nodes.data[index].is_expanded)
+        {
+            const ProofNumberNode* node = &pns->nodes.data[index];
+            uint32_t best = node->first_child;
+            for (uint32_t i=1; i<node->children_size; ++i)
+            {
+                const ProofNumberNode* child      = &pns->nodes.data[node->first_child + i];
+                const ProofNumberNode* best_child = &pns->nodes.data[best];
+                if (node->is_or ? child->proof < best_child->proof : child->disproof < best_child->disproof)
+                    best = node->first_child + i;
+            }
+            board_state_apply_move(&current, &pns->nodes.data[best].move);
+            index = best;
+            ++ply;
+        }
+        proof_number_search_expand(pns, index, &current, ply, plies);
+        proof_number_search_update(pns, index);
+    }
+    return pns->nodes.data[0].proof == 0;
+}
+
+// tries mates in 1, 2, .. moves, so the first proof is the shortest mate; returns its plies, 0 if none
+uint64_t proof_number_search_solve(ProofNumberSearch* pns, const BoardState* state, uint64_t mate, Move* pv, size_t* pv_size, size_t pv_capacity)
+{
+    assert(pns != NULL);
+    assert(state != NULL);
+    assert(pv != NULL);
+    assert(pv_size != NULL);
+    *pv_size = 0;
+    for (uint64_t moves=1; moves<=mate && 2*moves-1<=pv_capacity; ++moves)
+    {
+        if (!proof_number_search_prove(pns, state, 2*moves - 1))
+        {
+            // disproven means no mate this short, anything else means we ran out of nodes or time
+            if (pns->nodes.data[0].disproof == 0)
+                continue;
+            return 0;
+        }
+        const uint32_t mate_plies = proof_number_search_set_mate_plies(pns, 0);
+        uint32_t index = 0;
+        while (pns->nodes.data[index].is_expanded && *pv_size < pv_capacity)
+        {
+            const ProofNumberNode* node = &pns->nodes.data[index];
+            const uint32_t parent = index;
+            for (uint32_t i=0; i<node->children_size; ++i)
+            {
+                const ProofNumberNode* child = &pns->nodes.data[node->first_child + i];
+                if (child->proof == 0 && child->mate_plies + 1 == node->mate_plies)
+                {
+                    index = node->first_child + i;
+                    break;
+                }
+            }
+            if (index == parent)
+                break;
+            pv[(*pv_size)++] = pns->nodes.data[index].move;
+        }
+        return mate_plies;
+    }
+    return 0;
+}
+
@@ -0,0 +1,58 @@
+#ifndef PROOF_NUMBER_SEARCH_H
+#define PROOF_NUMBER_SEARCH_H
+
+// "Proof-Number Search", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Proof-Number_Search
+// Allis, van der Meulen, van den Herik, _Proof-Number Search_
+// https://doi.org/10.1016/0004-3702(94)90004-3
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "board_state.h"
+#include "dyn_array.h"
+
+// children of a node are stored next to each other, nodes refer to each other by index
+typedef struct
+{
+    Move move;
+    bool is_or;
+    bool is_expanded;
+    uint16_t children_size;
+    uint32_t parent;
+    uint32_t first_child;
+    uint32_t proof;
+    uint32_t disproof;
+    // plies to the mate, only valid in a proven subtree
+    uint32_t mate_plies;
+} ProofNumberNode;
+
+DEFINE_DYN_ARRAY(ProofNumberNode, dyn_array_proof_number_node)
+
+// asked every expansion whether to give up
+typedef bool (*proof_number_search_stop_t)(void* arg);
+// told how many nodes every expansion created
+typedef void (*proof_number_search_count_t)(void* arg, uint64_t nodes);
+
+#define PROOF_NUMBER_INFINITE UINT32_MAX
+#define PROOF_NUMBER_NODES_CAPACITY 4096
+
+typedef struct
+{
+    dyn_array_proof_number_node nodes;
+    proof_number_search_stop_t stop;
+    proof_number_search_count_t count;
+    void* arg;
+    // the proof is given up once the tree would outgrow this
+    size_t nodes_max;
+} ProofNumberSearch;
+
+void proof_number_search_alloc(ProofNumberSearch* pns, size_t size_mb, proof_number_search_stop_t stop, proof_number_search_count_t count, void* arg);
+void proof_number_search_free(ProofNumberSearch* pns);
+
+bool proof_number_search_prove(ProofNumberSearch* pns, const BoardState* state, uint64_t plies);
+uint64_t proof_number_search_solve(ProofNumberSearch* pns, const BoardState* state, uint64_t mate, Move* pv, size_t* pv_size, size_t pv_capacity);
+
+#endif // PROOF_NUMBER_SEARCH_H
+
@@ -0,0 +1,893 @@
+#include "search.h"
+
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include "utils.h"
+
+// ordering scores, from first to last
+#define SCORE_TT_MOVE (1 << 30)
+#define SCORE_CAPTURE (1 << 24)
+#define SCORE_KILLER  (1 << 20)
+#define SCORE_COUNTERMOVE (SCORE_KILLER - 1)
+#define SCORE_LOSING_CAPTURE (-(1 << 24))
+
+// late move reductions grow with log(depth) * log(move index)
+static uint8_t reductions[SEARCH_DEPTH_MAX + 1][BOARD_STATE_MOVES_SIZE];
+
+void search_init(void)
+{
+    for (size_t depth=1; depth<=SEARCH_DEPTH_MAX; ++depth)
+        for (size_t index=1; index<BOARD_STATE_MOVES_SIZE; ++index)
+            reductions[depth][index] = (uint8_t)(0.75 + log((double)depth) * log((double)index) / 2.25);
+}
+
+void search_thread_init(SearchThread* thread, TranspositionTable* tt)
+{
+    assert(thread != NULL);
+    thread->index         = 0;
+    thread->tt            = tt;
+    thread->params        = SEARCH_PARAMS_DEFAULT;
+    thread->limits        = (SearchLimits){0};
+    thread->stop          = NULL;
+    thread->ponder        = NULL;
+    thread->pool_nodes    = NULL;
+    thread->on_iteration     = NULL;
+    thread->on_iteration_arg = NULL;
+    memset(thread->history, 0, sizeof(thread->history));
+    memset(thread->countermoves, 0, sizeof(thread->countermoves));
+    memset(thread->continuation_history, 0, sizeof(thread->continuation_history));
+    search_thread_new_search(thread);
+}
+
+// everything tied to the previous root goes, the history tables stay
+void search_thread_new_search(SearchThread* thread)
+{
+    assert(thread != NULL);
+    time_manager_init(&thread->time_manager, 0, 0, 0, 0, 0, false);
+    thread->is_pondering  = false;
+    thread->is_clock_started = false;
+    thread->is_aborted    = false;
+    thread->root_bestmove = (Move){0};
+    thread->bestmove      = (Move){0};
+    thread->score         = 0;
+    thread->depth         = 0;
+    thread->pv_index      = 0;
+    thread->lines_size    = 0;
+    memset(thread->stack, 0, sizeof(thread->stack));
+    memset(thread->pv_size, 0, sizeof(thread->pv_size));
+    memset(thread->killers, 0, sizeof(thread->killers));
+    memset(&thread->stats, 0, sizeof(thread->stats));
+}
+
+void search_start_clock(SearchThread* thread)
+{
+    assert(thread != NULL);
+    const SearchLimits* limits = &thread->limits;
+    time_manager_init(&thread->time_manager, limits->time, limits->increment, limits->movestogo, limits->movetime, limits->move_overhead, limits->is_ponder_enabled);
+    thread->is_pondering     = limits->is_ponder;
+    thread->is_clock_started = true;
+    thread->is_aborted       = false;
+}
+
+// only the owning thread writes, so a relaxed load and store is enough for lock-free readers
+static void search_count(uint64_t* counter)
+{
+    __atomic_store_n(counter, *counter + 1, __ATOMIC_RELAXED);
+}
+
+// the pool count has many writers, so it takes an atomic add
+void search_count_nodes(SearchThread* thread, uint64_t nodes)
+{
+    assert(thread != NULL);
+    __atomic_store_n(&thread->stats.nodes, thread->stats.nodes + nodes, __ATOMIC_RELAXED);
+    if (thread->pool_nodes)
+        __atomic_fetch_add(thread->pool_nodes, nodes, __ATOMIC_RELAXED);
+}
+
+static void search_update_seldepth(SearchThread* thread, uint64_t ply)
+{
+    if (ply > thread->stats.seldepth)
+        __atomic_store_n(&thread->stats.seldepth, ply, __ATOMIC_RELAXED);
+}
+
+void search_stats_add(SearchStats* total, const SearchStats* stats)
+{
+    assert(total != NULL);
+    assert(stats != NULL);
+    total->nodes              += __atomic_load_n(&stats->nodes, __ATOMIC_RELAXED);
+    total->qnodes             += __atomic_load_n(&stats->qnodes, __ATOMIC_RELAXED);
+    total->tt_probes          += __atomic_load_n(&stats->tt_probes, __ATOMIC_RELAXED);
+    total->tt_hits            += __atomic_load_n(&stats->tt_hits, __ATOMIC_RELAXED);
+    total->beta_cutoffs       += __atomic_load_n(&stats->beta_cutoffs, __ATOMIC_RELAXED);
+    total->first_move_cutoffs += __atomic_load_n(&stats->first_move_cutoffs, __ATOMIC_RELAXED);
+    total->quiet_cutoffs      += __atomic_load_n(&stats->quiet_cutoffs, __ATOMIC_RELAXED);
+    total->quiet_cutoff_moves += __atomic_load_n(&stats->quiet_cutoff_moves, __ATOMIC_RELAXED);
+    total->null_move_cutoffs  += __atomic_load_n(&stats->null_move_cutoffs, __ATOMIC_RELAXED);
+    total->lmr_researches     += __atomic_load_n(&stats->lmr_researches, __ATOMIC_RELAXED);
+    total->extensions         += __atomic_load_n(&stats->extensions, __ATOMIC_RELAXED);
+    total->playouts           += __atomic_load_n(&stats->playouts, __ATOMIC_RELAXED);
+    // the deepest line of any thread
+    const uint64_t seldepth = __atomic_load_n(&stats->seldepth, __ATOMIC_RELAXED);
+    if (seldepth > total->seldepth)
+        total->seldepth = seldepth;
+}
+
+static uint64_t search_get_budget_nodes(const SearchThread* thread)
+{
+    return thread->pool_nodes ? __atomic_load_n(thread->pool_nodes, __ATOMIC_RELAXED) : thread->stats.nodes;
+}
+
+bool search_is_aborted(SearchThread* thread)
+{
+    assert(thread != NULL);
+    if (thread->is_aborted)
+        return true;
+    if (thread->stop && __atomic_load_n(thread->stop, __ATOMIC_RELAXED))
+        thread->is_aborted = true;
+    // checked before the node is counted, so the budget is exact. threads sharing it may each
+    // pass the check at the same time, and overrun it by one node apiece
+    else if (thread->limits.nodes && search_get_budget_nodes(thread) >= thread->limits.nodes)
+        thread->is_aborted = true;
+    else if (thread->stats.nodes % SEARCH_NODES_CHECK_INTERVAL == 0
+        && !search_is_pondering(thread)
+        && time_manager_is_hard_expired(&thread->time_manager))
+        thread->is_aborted = true;
+    return thread->is_aborted;
+}
+
+bool search_is_pondering(SearchThread* thread)
+{
+    assert(thread != NULL);
+    if (!thread->is_pondering)
+        return false;
+    if (thread->ponder && __atomic_load_n(thread->ponder, __ATOMIC_RELAXED))
+        return true;
+    // ponderhit: the search goes on, but our clock starts now
+    thread->is_pondering = false;
+    thread->time_manager.start_time = time_now_seconds();
+    return false;
+}
+
+static bool search_is_quiet(const BoardState* state, const Move* move)
+{
+    return !(move->fields & MOVE_FIELDS_QUEENING_CHOICE_Q)
+        && !(move->to & bitboard_get_all_pieces(&state->board))
+        && !((move->to & state->en_passant_square) && (move->from & state->board.p));
+}
+
+// 1 (pawn) to 6 (king), en passant captures a pawn
+static int32_t search_piece_rank(piece_t piece)
+{
+    return (piece == PIECE_NONE) ? 1 : ((piece - 1) % (PIECE_WK - PIECE_NONE)) + 1;
+}
+
+// "MVV-LVA", _Chessprogramming wiki_
+// https://www.chessprogramming.org/MVV-LVA
+static int32_t search_mvv_lva(const BoardState* state, const Move* move)
+{
+    const piece_t victim   = bitboard_get_piece(&state->board, move->to);
+    const piece_t attacker = bitboard_get_piece(&state->board, move->from);
+    int32_t score = 8 * search_piece_rank(victim) - search_piece_rank(attacker);
+    if (move->fields & MOVE_FIELDS_QUEENING_CHOICE_Q)
+        score += 8 * search_piece_rank(PIECE_WQ);
+    return score;
+}
+
+// the most a capture or promotion can win: the captured piece, plus the promoted pawn's growth
+static evaluation_t search_get_material_gain(const BoardState* state, const Move* move)
+{
+    const piece_t victim = bitboard_get_piece(&state->board, move->to);
+    evaluation_t gain = 0;
+    if (victim != PIECE_NONE)
+        gain = board_state_evaluate_piece(victim);
+    else if ((move->to & state->en_passant_square) && (move->from & state->board.p))
+        gain = EVALUATION_PAWN;
+    if (move->fields & MOVE_FIELDS_QUEENING_CHOICE_Q)
+        gain += EVALUATION_QUEEN - EVALUATION_PAWN;
+    return gain;
+}
+
+// the previous iteration's pv move at this ply, as long as the game follows that pv
+static const Move* search_get_pv_move(const SearchThread* thread, uint64_t ply)
+{
+    if (!thread->stack[ply].is_on_pv || thread->pv_index >= thread->lines_size)
+        return NULL;
+    const SearchLine* line = &thread->lines[thread->pv_index];
+    return (ply < line->pv_size) ? &line->pv[ply] : NULL;
+}
+
+static void search_update_pv(SearchThread* thread, const Move* move, uint64_t ply)
+{
+    thread->pv[ply][0] = *move;
+    memcpy(&thread->pv[ply][1], thread->pv[ply + 1], thread->pv_size[ply + 1] * sizeof(Move));
+    thread->pv_size[ply] = thread->pv_size[ply + 1] + 1;
+}
+
+static bool search_is_root_excluded(const SearchThread* thread, const Move* move)
+{
+    for (size_t i=0; i<thread->pv_index; ++i)
+        if (move_is_equal(move, &thread->current_lines[i].move))
+            return true;
+    return false;
+}
+
+// a capture by a cheaper piece can never lose material, so skip the exchange
+static bool search_is_losing_capture(const BoardState* state, const Move* move)
+{
+    const evaluation_t victim   = board_state_evaluate_piece(bitboard_get_piece(&state->board, move->to));
+    const evaluation_t attacker = board_state_evaluate_piece(bitboard_get_piece(&state->board, move->from));
+    if (attacker <= victim)
+        return false;
+    return board_state_see(state, move) < 0;
+}
+
+// butterfly history plus continuation history of the moves one and two plies back
+static int32_t search_quiet_history(const SearchThread* thread, const BoardState* state, const Move* move, uint64_t ply)
+{
+    const int side      = board_state_is_white(state) ? 0 : 1;
+    const piece_t piece = bitboard_get_piece(&state->board, move->from);
+    const int from      = __builtin_ctzll(move->from);
+    const int to        = __builtin_ctzll(move->to);
+    int32_t score = thread->history[side][from][to];
+    for (uint64_t back=1; back<=2 && back<=ply; ++back)
+    {
+        const SearchStackEntry* entry = &thread->stack[ply - back];
+        if (entry->moved_piece != PIECE_NONE)
+            score += thread->continuation_history[entry->moved_piece][entry->moved_to][piece][to];
+    }
+    return score;
+}
+
+static const Move* search_get_countermove(const SearchThread* thread, uint64_t ply)
+{
+    if (ply == 0 || thread->stack[ply - 1].moved_piece == PIECE_NONE)
+        return NULL;
+    const SearchStackEntry* entry = &thread->stack[ply - 1];
+    return &thread->countermoves[entry->moved_piece][entry->moved_to];
+}
+
+static void search_score_moves(const SearchThread* thread, const BoardState* state, const Move* moves, int32_t* scores, size_t moves_size, const Move* tt_move, uint64_t ply)
+{
+    const Move* countermove = search_get_countermove(thread, ply);
+    for (size_t i=0; i<moves_size; ++i)
+    {
+        const Move* move = &moves[i];
+        if (move_is_equal(move, tt_move))
+            scores[i] = SCORE_TT_MOVE;
+        else if (!search_is_quiet(state, move))
+            scores[i] = (search_is_losing_capture(state, move) ? SCORE_LOSING_CAPTURE : SCORE_CAPTURE)
+                + search_mvv_lva(state, move);
+        else if (move_is_equal(move, &thread->killers[ply][0]))
+            scores[i] = SCORE_KILLER + 1;
+        else if (move_is_equal(move, &thread->killers[ply][1]))
+            scores[i] = SCORE_KILLER;
+        else if (countermove && move_is_equal(move, countermove))
+            scores[i] = SCORE_COUNTERMOVE;
+        else
+            scores[i] = search_quiet_history(thread, state, move, ply);
+    }
+}
+
+// partial selection sort: swap the best scored remaining move to index
+static void search_pick_move(Move* moves, int32_t* scores, size_t moves_size, size_t index)
+{
+    size_t best = index;
+    for (size_t i=index+1; i<moves_size; ++i)
+        if (scores[i] > scores[best])
+            best = i;
+    if (best == index)
+        return;
+    const Move move_temp     = moves[index];
+    const int32_t score_temp = scores[index];
+    moves[index]  = moves[best];
+    scores[index] = scores[best];
+    moves[best]   = move_temp;
+    scores[best]  = score_temp;
+}
+
+static bool search_has_non_pawn_material(const BoardState* state)
+{
+    const Bitboard* board = &state->board;
+    const square_t own    = board_state_is_white(state) ? board->w : ~board->w;
+    return own & (board->n | board->b | board->r | board->q);
+}
+
+// gravity: bonuses shrink as an entry nears the bound, so it never needs aging
+static int32_t search_history_gravity(int32_t value, int32_t bonus)
+{
+    return value + bonus - value * (bonus < 0 ? -bonus : bonus) / SEARCH_HISTORY_MAX;
+}
+
+static void search_update_quiet_history(SearchThread* thread, const BoardState* state, const Move* move, int32_t bonus, uint64_t ply)
+{
+    const int side      = board_state_is_white(state) ? 0 : 1;
+    const piece_t piece = bitboard_get_piece(&state->board, move->from);
+    const int from      = __builtin_ctzll(move->from);
+    const int to        = __builtin_ctzll(move->to);
+    int32_t* history = &thread->history[side][from][to];
+    *history = search_history_gravity(*history, bonus);
+    for (uint64_t back=1; back<=2 && back<=ply; ++back)
+    {
+        const SearchStackEntry* entry = &thread->stack[ply - back];
+        if (entry->moved_piece == PIECE_NONE)
+            continue;
+        int16_t* continuation = &thread->continuation_history[entry->moved_piece][entry->moved_to][piece][to];
+        *continuation = (int16_t)search_history_gravity(*continuation, bonus);
+    }
+}
+
+// reward the cutoff move, punish the quiet moves tried before it
+static void search_update_quiet_cutoff(SearchThread* thread, const BoardState* state, const Move* move, const Move* quiets, size_t quiets_size, uint64_t depth, uint64_t ply)
+{
+    if (!move_is_equal(move, &thread->killers[ply][0]))
+    {
+        thread->killers[ply][1] = thread->killers[ply][0];
+        thread->killers[ply][0] = *move;
+    }
+    if (ply > 0 && thread->stack[ply - 1].moved_piece != PIECE_NONE)
+    {
+        const SearchStackEntry* entry = &thread->stack[ply - 1];
+        thread->countermoves[entry->moved_piece][entry->moved_to] = *move;
+    }
+    const int32_t bonus = (depth * depth < SEARCH_HISTORY_BONUS_MAX) ? (int32_t)(depth * depth) : SEARCH_HISTORY_BONUS_MAX;
+    search_update_quiet_history(thread, state, move, bonus, ply);
+    for (size_t i=0; i<quiets_size; ++i)
+        search_update_quiet_history(thread, state, &quiets[i], -bonus, ply);
+}
+
+evaluation_t search_quiescence(SearchThread* thread, const BoardState* state, evaluation_t alpha, evaluation_t beta, uint64_t ply)
+{
+    assert(thread != NULL);
+    assert(state != NULL);
+    if (search_is_aborted(thread))
+        return 0;
+    search_count_nodes(thread, 1);
+    search_count(&thread->stats.qnodes);
+    search_update_seldepth(thread, ply);
+    const evaluation_t stand_pat = board_state_evaluate_abs(state);
+    if (stand_pat >= beta || ply >= SEARCH_DEPTH_MAX)
+        return stand_pat;
+    if (stand_pat > alpha)
+        alpha = stand_pat;
+    Move moves[BOARD_STATE_MOVES_SIZE];
+    int32_t scores[BOARD_STATE_MOVES_SIZE];
+    const size_t moves_size = board_state_get_pseudo_legal_captures(state, moves, BOARD_STATE_MOVES_SIZE);
+    for (size_t i=0; i<moves_size; ++i)
+        scores[i] = search_mvv_lva(state, &moves[i]);
+    evaluation_t best = stand_pat;
+    for (size_t i=0; i<moves_size; ++i)
+    {
+        search_pick_move(moves, scores, moves_size, i);
+        const Move* move = &moves[i];
+        // delta pruning: even winning the piece outright cannot raise alpha
+        if (stand_pat + search_get_material_gain(state, move) + thread->params.delta_margin <= alpha)
+            continue;
+        if (search_is_losing_capture(state, move))
+            continue;
+        BoardState copy = {0};
+        board_state_copy(state, &copy);
+        if (board_state_apply_move(&copy, move) != APPLY_MOVE_STATUS_OK)
+            continue;
+        const evaluation_t evaluation = -search_quiescence(thread, &copy, -beta, -alpha, ply + 1);
+        if (thread->is_aborted)
+            return 0;
+        if (evaluation > best)
+            best = evaluation;
+        if (best > alpha)
+            alpha = best;
+        if (alpha >= beta)
+            break;
+    }
+    return best;
+}
+
+evaluation_t search_negamax(SearchThread* thread, const BoardState* state, evaluation_t alpha, evaluation_t beta, uint64_t depth, uint64_t ply)
+{
+    assert(thread != NULL);
+    assert(state != NULL);
+    thread->pv_size[ply] = 0;
+    if (depth == 0 && thread->params.is_quiescence_enabled)
+        return search_quiescence(thread, state, alpha, beta, ply);
+    if (search_is_aborted(thread))
+        return 0;
+    search_count_nodes(thread, 1);
+    search_update_seldepth(thread, ply);
+    if (depth == 0 || ply >= SEARCH_DEPTH_MAX)
+        return board_state_evaluate_abs(state);
+    // mate distance pruning: no line from here beats a mate already found closer to the root
+    if (ply > 0)
+    {
+        if (alpha < -(EVALUATION_MATE - (evaluation_t)ply))
+            alpha = -(EVALUATION_MATE - (evaluation_t)ply);
+        if (beta > EVALUATION_MATE - (evaluation_t)ply - 1)
+            beta = EVALUATION_MATE - (evaluation_t)ply - 1;
+        if (alpha >= beta)
+            return alpha;
+    }
+    const evaluation_t alpha_original = alpha;
+    const uint64_t hash = board_state_get_hash(state);
+    if (ply == 0)
+    {
+        thread->stack[ply].extensions   = 0;
+        thread->stack[ply].is_on_pv     = true;
+        thread->stack[ply].is_verifying = false;
+    }
+    // a singular search looks at the same position minus one move, so it must not share its entry
+    const Move excluded_move = thread->stack[ply].excluded_move;
+    const bool is_excluding  = excluded_move.from != 0;
+    const bool is_pv = beta - alpha > 1;
+    Move tt_move = {0};
+    TranspositionTableRecord record;
+    const bool is_tt_probe = thread->tt && !is_excluding;
+    const bool is_tt_hit   = is_tt_probe && transposition_table_probe(thread->tt, hash, ply, &record);
+    if (is_tt_probe)
+        search_count(&thread->stats.tt_probes);
+    if (is_tt_hit)
+        search_count(&thread->stats.tt_hits);
+    if (is_tt_hit)
+    {
+        tt_move = record.move;
+        // a pv node searches on, so the pv reaches past the table
+        if (ply > 0 && !is_pv && record.depth >= depth
+            && (record.bound == TRANSPOSITION_TABLE_BOUND_EXACT
+                || (record.bound == TRANSPOSITION_TABLE_BOUND_LOWER && record.score >= beta)
+                || (record.bound == TRANSPOSITION_TABLE_BOUND_UPPER && record.score <= alpha)))
+            return record.score;
+    }
+    const bool is_in_check = board_state_get_attacked_kings(state, board_state_is_white(state));
+    const bool is_pruning  = thread->params.is_pruning_enabled && !is_pv && !is_in_check && ply > 0;
+    const evaluation_t static_evaluation = board_state_evaluate_abs(state);
+    thread->stack[ply].is_null_move = false;
+    // reverse futility: far enough above beta that no quiet reply will bring it back
+    if (is_pruning
+        && depth <= thread->params.reverse_futility_depth
+        && static_evaluation - thread->params.reverse_futility_margin * (evaluation_t)depth >= beta)
+        return static_evaluation;
+    // razoring: hopeless near the leaves unless a capture saves it
+    if (is_pruning
+        && thread->params.is_quiescence_enabled
+        && depth <= thread->params.razoring_depth
+        && static_evaluation + thread->params.razoring_margin * (evaluation_t)depth <= alpha)
+    {
+        const evaluation_t evaluation = search_quiescence(thread, state, alpha, beta, ply);
+        if (thread->is_aborted)
+            return 0;
+        if (evaluation <= alpha)
+            return evaluation;
+    }
+    // null move: if passing still fails high, a real move will too.
+    // zugzwang makes this unsound, so skip pawn endings and verify deep cutoffs
+    if (is_pruning
+        && depth >= thread->params.null_move_depth
+        && !thread->stack[ply-1].is_null_move
+        && !is_excluding
+        && search_has_non_pawn_material(state)
+        && static_evaluation >= beta)
+    {
+        const uint64_t reduction = thread->params.null_move_reduction + depth / 4;
+        const uint64_t null_depth = (depth > reduction + 1) ? depth - reduction - 1 : 0;
+        BoardState copy = {0};
+        board_state_copy(state, &copy);
+        board_state_apply_null_move(&copy);
+        thread->stack[ply].is_null_move   = true;
+        thread->stack[ply].moved_piece    = PIECE_NONE;
+        thread->stack[ply].captured_piece = PIECE_NONE;
+        thread->stack[ply + 1].extensions     = thread->stack[ply].extensions;
+        thread->stack[ply + 1].is_on_pv       = false;
+        thread->stack[ply + 1].is_verifying   = thread->stack[ply].is_verifying;
+        evaluation_t evaluation = -search_negamax(thread, &copy, -beta, -beta + 1, null_depth, ply + 1);
+        thread->stack[ply].is_null_move = false;
+        if (thread->is_aborted)
+            return 0;
+        if (evaluation >= beta)
+        {
+            // a null move does not prove a mate
+            if (evaluation_is_mate(evaluation))
+                evaluation = beta;
+            bool is_verified = depth < thread->params.null_move_verification_depth || thread->stack[ply].is_verifying;
+            if (!is_verified)
+            {
+                thread->stack[ply].is_verifying = true;
+                const evaluation_t verification = search_negamax(thread, state, beta - 1, beta, depth - reduction, ply);
+                thread->stack[ply].is_verifying = false;
+                if (thread->is_aborted)
+                    return 0;
+                is_verified = verification >= beta;
+            }
+            if (is_verified)
+            {
+                search_count(&thread->stats.null_move_cutoffs);
+                return evaluation;
+            }
+        }
+    }
+    // the previous iteration's pv goes first: always at the root, elsewhere when the table has no move
+    const Move* pv_move = search_get_pv_move(thread, ply);
+    if (pv_move && (ply == 0 || !tt_move.from))
+        tt_move = *pv_move;
+    else if (ply == 0 && thread->bestmove.from)
+        tt_move = thread->bestmove;
+    // singular: if every other move fails low against a margin below the tt score,
+    // the tt move is the only one holding this position and deserves a deeper look
+    const bool is_extending = thread->params.is_extensions_enabled
+        && thread->stack[ply].extensions < thread->params.extensions_max;
+    bool is_singular = false;
+    if (is_extending
+        && ply > 0
+        && depth >= thread->params.singular_depth
+        && is_tt_hit
+        && record.move.from
+        && move_is_equal(&tt_move, &record.move)
+        && (uint64_t)record.depth + 3 >= depth
+        && record.bound != TRANSPOSITION_TABLE_BOUND_UPPER
+        && !evaluation_is_mate(record.score))
+    {
+        const evaluation_t singular_beta = record.score - thread->params.singular_margin * (evaluation_t)depth;
+        thread->stack[ply].excluded_move = tt_move;
+        const evaluation_t evaluation = search_negamax(thread, state, singular_beta - 1, singular_beta, (depth - 1) / 2, ply);
+        thread->stack[ply].excluded_move = (Move){0};
+        if (thread->is_aborted)
+            return 0;
+        is_singular = evaluation < singular_beta;
+    }
+    Move moves[BOARD_STATE_MOVES_SIZE];
+    int32_t scores[BOARD_STATE_MOVES_SIZE];
+    const size_t moves_size = board_state_get_pseudo_legal_moves(state, moves, BOARD_STATE_MOVES_SIZE);
+    search_score_moves(thread, state, moves, scores, moves_size, &tt_move, ply);
+    // futility: quiet moves cannot raise a static eval this far below alpha
+    const evaluation_t futility_evaluation = static_evaluation + thread->params.futility_margin * (evaluation_t)depth;
+    const bool is_futile = is_pruning
+        && depth <= thread->params.futility_depth
+        && futility_evaluation <= alpha;
+    // fail-soft: best may end up outside of [alpha, beta]
+    evaluation_t best = -EVALUATION_INFINITE;
+    Move best_move    = {0};
+    size_t legal_size = 0;
+    Move quiets[SEARCH_QUIETS_SIZE];
+    size_t quiets_size = 0;
+    for (size_t i=0; i<moves_size; ++i)
+    {
+        search_pick_move(moves, scores, moves_size, i);
+        const Move* move = &moves[i];
+        if (is_excluding && move_is_equal(move, &excluded_move))
+            continue;
+        if (ply == 0 && search_is_root_excluded(thread, move))
+            continue;
+        const piece_t piece    = bitboard_get_piece(&state->board, move->from);
+        const piece_t captured = bitboard_get_piece(&state->board, move->to);
+        BoardState copy  = {0};
+        board_state_copy(state, &copy);
+        if (board_state_apply_move(&copy, move) != APPLY_MOVE_STATUS_OK)
+            continue;
+        ++legal_size;
+        const bool is_quiet = search_is_quiet(state, move);
+        const bool is_check = board_state_get_attacked_kings(&copy, board_state_is_white(&copy));
+        if (is_futile && legal_size > 1 && is_quiet && !is_check)
+        {
+            if (futility_evaluation > best)
+                best = futility_evaluation;
+            continue;
+        }
+        // late quiet moves and losing captures get reduced, less so when they look promising
+        const bool is_losing_capture = scores[i] < SCORE_LOSING_CAPTURE / 2;
+        uint64_t reduction = 0;
+        if (thread->params.is_pruning_enabled
+            && depth >= thread->params.lmr_depth
+            && legal_size > thread->params.lmr_moves
+            && ((is_quiet && scores[i] < SCORE_CAPTURE) || is_losing_capture)
+            && !is_in_check
+            && !is_check)
+        {
+            int64_t r = reductions[depth][legal_size];
+            if (is_pv)
+                --r;
+            if (scores[i] >= SCORE_KILLER || scores[i] > SEARCH_HISTORY_MAX / 2)
+                --r;
+            if (is_losing_capture)
+                ++r;
+            if (r > (int64_t)depth - 2)
+                r = depth - 2;
+            reduction = (r > 0) ? r : 0;
+        }
+        // a capture on the square the opponent just captured on; stack[ply - 1] holds the move that led here.
+        // only a piece of the same value is a true recapture, anything else already changed the balance
+        const bool is_recapture = ply > 0
+            && captured != PIECE_NONE
+            && thread->stack[ply - 1].captured_piece != PIECE_NONE
+            && thread->stack[ply - 1].moved_to == __builtin_ctzll(move->to)
+            && board_state_evaluate_piece(captured) == board_state_evaluate_piece(thread->stack[ply - 1].captured_piece);
+        // extend checks, recaptures on the pv and singular tt moves, at most one ply per move
+        uint64_t extension = 0;
+        if (is_extending
+            && (is_check
+                || (is_pv && is_recapture)
+                || (is_singular && move_is_equal(move, &tt_move))))
+        {
+            extension = 1;
+            search_count(&thread->stats.extensions);
+        }
+        const uint64_t new_depth = depth - 1 + extension;
+        thread->stack[ply].moved_piece    = piece;
+        thread->stack[ply].moved_to       = __builtin_ctzll(move->to);
+        thread->stack[ply].captured_piece = captured;
+        thread->stack[ply + 1].extensions     = thread->stack[ply].extensions + extension;
+        thread->stack[ply + 1].is_on_pv       = pv_move && move_is_equal(move, pv_move);
+        thread->stack[ply + 1].is_verifying   = thread->stack[ply].is_verifying;
+        // PVS: prove the remaining moves worse with a null window, re-search on fail-high
+        evaluation_t evaluation;
+        if (legal_size == 1)
+        {
+            evaluation = -search_negamax(thread, &copy, -beta, -alpha, new_depth, ply + 1);
+        }
+        else
+        {
+            evaluation = -search_negamax(thread, &copy, -alpha - 1, -alpha, new_depth - reduction, ply + 1);
+            if (reduction > 0 && evaluation > alpha && !thread->is_aborted)
+            {
+                search_count(&thread->stats.lmr_researches);
+                evaluation = -search_negamax(thread, &copy, -alpha - 1, -alpha, new_depth, ply + 1);
+            }
+            if (evaluation > alpha && evaluation < beta && !thread->is_aborted)
+                evaluation = -search_negamax(thread, &copy, -beta, -alpha, new_depth, ply + 1);
+        }
+        if (thread->is_aborted)
+            return 0;
+        if (evaluation > best || legal_size == 1)
+        {
+            best      = evaluation;
+            best_move = *move;
+            if (ply == 0)
+                thread->root_bestmove = *move;
+            if (is_pv && evaluation > alpha)
+                search_update_pv(thread, move, ply);
+        }
+        if (best > alpha)
+            alpha = best;
+        if (alpha >= beta)
+        {
+            search_count(&thread->stats.beta_cutoffs);
+            if (legal_size == 1)
+                search_count(&thread->stats.first_move_cutoffs);
+            if (is_quiet)
+            {
+                search_count(&thread->stats.quiet_cutoffs);
+                __atomic_store_n(&thread->stats.quiet_cutoff_moves, thread->stats.quiet_cutoff_moves + quiets_size + 1, __ATOMIC_RELAXED);
+                search_update_quiet_cutoff(thread, state, move, quiets, quiets_size, depth, ply);
+            }
+            break;
+        }
+        if (is_quiet && quiets_size < SEARCH_QUIETS_SIZE)
+            quiets[quiets_size++] = *move;
+    }
+    // the excluded move was the only one: no mate, just nothing else to try, so that move is singular
+    if (legal_size == 0 && is_excluding)
+        return alpha;
+    if (legal_size == 0)
+        return is_in_check ? -(EVALUATION_MATE - (evaluation_t)ply) : EVALUATION_DRAW;
+    // a multipv line below the first is not the root's real score
+    if (thread->tt && !is_excluding && !(ply == 0 && thread->pv_index > 0))
+    {
+        const transposition_table_bound_t bound =
+            (best <= alpha_original) ? TRANSPOSITION_TABLE_BOUND_UPPER
+            : (best >= beta)         ? TRANSPOSITION_TABLE_BOUND_LOWER
+            : TRANSPOSITION_TABLE_BOUND_EXACT;
+        transposition_table_store(thread->tt, hash, ply, &best_move, best, depth, bound);
+    }
+    return best;
+}
+
+evaluation_t search_root(SearchThread* thread, const BoardState* state, uint64_t depth)
+{
+    assert(thread != NULL);
+    assert(state != NULL);
+    return search_negamax(thread, state, -EVALUATION_INFINITE, EVALUATION_INFINITE, depth, 0);
+}
+
+evaluation_t search_aspiration(SearchThread* thread, const BoardState* state, uint64_t depth, evaluation_t previous)
+{
+    assert(thread != NULL);
+    assert(state != NULL);
+    if (depth < thread->params.aspiration_depth || evaluation_is_mate(previous))
+        return search_root(thread, state, depth);
+    evaluation_t delta = thread->params.aspiration_window;
+    evaluation_t alpha = previous - delta;
+    evaluation_t beta  = previous + delta;
+    for (;;)
+    {
+        thread->root_bestmove = (Move){0};
+        const evaluation_t evaluation = search_negamax(thread, state, alpha, beta, depth, 0);
+        if (thread->is_aborted)
+            return 0;
+        // widen the failing side until the score lands inside the window
+        delta *= 2;
+        if (evaluation <= alpha && alpha > -EVALUATION_INFINITE)
+            alpha = (delta >= EVALUATION_QUEEN || evaluation_is_mate(evaluation)) ? -EVALUATION_INFINITE : evaluation - delta;
+        else if (evaluation >= beta && beta < EVALUATION_INFINITE)
+            beta = (delta >= EVALUATION_QUEEN || evaluation_is_mate(evaluation)) ? EVALUATION_INFINITE : evaluation + delta;
+        else
+            return evaluation;
+    }
+}
+
+// "MTD(f)", _Chessprogramming wiki_
+// https://www.chessprogramming.org/MTD(f)
+// every probe is a zero-window search that either raises the lower or lowers the upper bound,
+// the transposition table keeps the work of earlier probes. a probe that fails low has no best
+// move worth keeping, so the root move comes from the last probe that failed high. zero-window
+// probes collect no pv, so one narrow window around the converged score searches the pv line
+// as pv nodes, mostly out of the table
+evaluation_t search_mtdf(SearchThread* thread, const BoardState* state, uint64_t depth, evaluation_t guess)
+{
+    assert(thread != NULL);
+    assert(state != NULL);
+    evaluation_t lower = -EVALUATION_INFINITE;
+    evaluation_t upper = EVALUATION_INFINITE;
+    evaluation_t evaluation = guess;
+    Move bestmove = {0};
+    while (lower < upper)
+    {
+        const evaluation_t beta = (evaluation == lower) ? evaluation + 1 : evaluation;
+        thread->root_bestmove = (Move){0};
+        evaluation = search_negamax(thread, state, beta - 1, beta, depth, 0);
+        if (thread->is_aborted)
+            return 0;
+        if (evaluation < beta)
+            upper = evaluation;
+        else
+        {
+            lower    = evaluation;
+            bestmove = thread->root_bestmove;
+        }
+    }
+    thread->root_bestmove = (Move){0};
+    const evaluation_t pv_evaluation = search_negamax(thread, state, evaluation - 1, evaluation + 1, depth, 0);
+    if (thread->is_aborted)
+        return 0;
+    if (pv_evaluation == evaluation && thread->root_bestmove.from)
+        return evaluation;
+    // pv nodes prune less than the probes did, keep the probes' move when the pv search disagrees
+    if (bestmove.from)
+        thread->root_bestmove = bestmove;
+    return evaluation;
+}
+
+// the pv search fell outside its window, so the pv is read back from the table behind the best move
+static void search_extend_pv_from_tt(const SearchThread* thread, const BoardState* state, SearchLine* line, uint64_t depth)
+{
+    if (!thread->tt)
+        return;
+    BoardState copy = {0};
+    board_state_copy(state, &copy);
+    if (board_state_apply_move(&copy, &line->pv[0]) != APPLY_MOVE_STATUS_OK)
+        return;
+    while (line->pv_size < depth && line->pv_size <= SEARCH_DEPTH_MAX)
+    {
+        TranspositionTableRecord record;
+        if (!transposition_table_probe(thread->tt, board_state_get_hash(&copy), line->pv_size, &record))
+            return;
+        Move moves[BOARD_STATE_MOVES_SIZE];
+        const size_t moves_size = board_state_get_legal_moves(&copy, moves, BOARD_STATE_MOVES_SIZE);
+        size_t i = 0;
+        while (i < moves_size && !move_is_equal(&moves[i], &record.move))
+            ++i;
+        if (i == moves_size)
+            return;
+        line->pv[line->pv_size++] = moves[i];
+        board_state_apply_move(&copy, &moves[i]);
+    }
+}
+
+// a mate within the requested number of moves is proven, nothing left to search for
+static bool search_is_mate_found(const SearchThread* thread)
+{
+    if (!thread->limits.mate || !evaluation_is_mate(thread->score) || thread->score < 0)
+        return false;
+    const uint64_t plies = EVALUATION_MATE - thread->score;
+    return plies <= 2 * thread->limits.mate - 1;
+}
+
+// helpers spread over the depths so they fill the shared table ahead of the main thread
+static const uint64_t search_skip_sizes[SEARCH_SKIP_SIZE]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const uint64_t search_skip_phases[SEARCH_SKIP_SIZE] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+static bool search_is_depth_skipped(const SearchThread* thread, uint64_t depth)
+{
+    if (thread->index == 0)
+        return false;
+    const size_t i = (thread->index - 1) % SEARCH_SKIP_SIZE;
+    return ((depth + search_skip_phases[i]) / search_skip_sizes[i]) % 2;
+}
+
+evaluation_t search_iterative_deepening(SearchThread* thread, const BoardState* state, Move* bestmove)
+{
+    assert(thread != NULL);
+    assert(state != NULL);
+    if (!thread->is_clock_started)
+        search_start_clock(thread);
+    const uint64_t max_depth = (thread->limits.depth > 0 && thread->limits.depth < SEARCH_DEPTH_MAX)
+        ? thread->limits.depth
+        : SEARCH_DEPTH_MAX;
+    Move moves[BOARD_STATE_MOVES_SIZE];
+    const size_t moves_size = board_state_get_legal_moves(state, moves, BOARD_STATE_MOVES_SIZE);
+    size_t multipv = (thread->params.multipv > 0) ? thread->params.multipv : 1;
+    if (multipv > SEARCH_MULTIPV_MAX)
+        multipv = SEARCH_MULTIPV_MAX;
+    if (multipv > moves_size)
+        multipv = moves_size;
+    for (uint64_t depth=1; depth<=max_depth; ++depth)
+    {
+        if (search_is_depth_skipped(thread, depth) && depth < max_depth)
+            continue;
+        size_t lines_size = 0;
+        for (thread->pv_index=0; thread->pv_index<multipv; ++thread->pv_index)
+        {
+            const size_t i = thread->pv_index;
+            thread->root_bestmove = (Move){0};
+            const evaluation_t previous = (i < thread->lines_size) ? thread->lines[i].score : thread->score;
+            const evaluation_t score    = thread->params.is_mtdf_enabled
+                ? search_mtdf(thread, state, depth, previous)
+                : search_aspiration(thread, state, depth, previous);
+            if (thread->is_aborted || !thread->root_bestmove.from)
+                break;
+            SearchLine* line = &thread->current_lines[i];
+            line->move  = thread->root_bestmove;
+            line->score = score;
+            // a root that never raised alpha has no pv beyond its best move
+            if (thread->pv_size[0] > 0 && move_is_equal(&thread->pv[0][0], &line->move))
+            {
+                memcpy(line->pv, thread->pv[0], thread->pv_size[0] * sizeof(Move));
+                line->pv_size = thread->pv_size[0];
+            }
+            else
+            {
+                line->pv[0]   = line->move;
+                line->pv_size = 1;
+                if (thread->params.is_mtdf_enabled)
+                    search_extend_pv_from_tt(thread, state, line, depth);
+            }
+            lines_size = i + 1;
+        }
+        if (thread->is_aborted)
+        {
+            // an unfinished first iteration still beats having no move at all
+            if (thread->depth == 0 && thread->pv_index == 0 && thread->root_bestmove.from)
+            {
+                thread->bestmove = thread->root_bestmove;
+                if (bestmove)
+                    *bestmove = thread->bestmove;
+            }
+            break;
+        }
+        // lines are searched best first, but fail-soft scores may still come out of order
+        for (size_t i=1; i<lines_size; ++i)
+            for (size_t j=i; j>0 && thread->current_lines[j].score > thread->current_lines[j-1].score; --j)
+            {
+                const SearchLine line_temp = thread->current_lines[j];
+                thread->current_lines[j]   = thread->current_lines[j-1];
+                thread->current_lines[j-1] = line_temp;
+            }
+        memcpy(thread->lines, thread->current_lines, lines_size * sizeof(SearchLine));
+        thread->lines_size = lines_size;
+        thread->pv_index   = 0;
+        if (lines_size == 0)
+            break;
+        thread->bestmove = thread->lines[0].move;
+        thread->score    = thread->lines[0].score;
+        thread->depth    = depth;
+        if (bestmove)
+            *bestmove = thread->bestmove;
+        if (thread->on_iteration)
+            thread->on_iteration(thread->on_iteration_arg, thread);
+        if (search_is_mate_found(thread))
+            break;
+        // the next iteration would most likely not finish in time
+        time_manager_update(&thread->time_manager, &thread->bestmove, thread->score);
+        if (!search_is_pondering(thread) && time_manager_is_soft_expired(&thread->time_manager))
+            break;
+    }
+    thread->pv_index = 0;
+    return thread->score;
+}
+
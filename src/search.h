@@ -0,0 +1,251 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+// "Alpha-Beta", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Alpha-Beta
+// "Negamax", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Negamax
+// "Iterative Deepening", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Iterative_Deepening
+// "Quiescence Search", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Quiescence_Search
+// "Move Ordering", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Move_Ordering
+// "Principal Variation Search", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Principal_Variation_Search
+// "Aspiration Windows", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Aspiration_Windows
+// "Null Move Pruning", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Null_Move_Pruning
+// "Verified Null-Move Pruning", Tabibi, Netanyahu
+// https://arxiv.org/abs/cs/0208017
+// "Late Move Reductions", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Late_Move_Reductions
+// "Futility Pruning", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Futility_Pruning
+// "Reverse Futility Pruning", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Reverse_Futility_Pruning
+// "Razoring", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Razoring
+// "Extensions", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Extensions
+// "Singular Extensions", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Singular_Extensions
+// "Lazy SMP", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Lazy_SMP
+// "Countermove Heuristic", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Countermove_Heuristic
+// "History Heuristic", _Chessprogramming wiki_
+// https://www.chessprogramming.org/History_Heuristic
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "board_state.h"
+#include "transposition_table.h"
+#include "time_manager.h"
+
+typedef struct
+{
+    uint64_t depth;
+    // milliseconds, time and increment are the side to move's
+    uint64_t movetime;
+    uint64_t time;
+    uint64_t increment;
+    uint64_t movestogo;
+    uint64_t move_overhead;
+    // the clock does not run until ponderhit
+    bool is_ponder;
+    // the GUI's Ponder option, it may ponder on our time
+    bool is_ponder_enabled;
+    // stop after this many nodes of the searching thread, its share of the pool's budget
+    uint64_t nodes;
+    // stop once a mate in this many moves is proven
+    uint64_t mate;
+} SearchLimits;
+
+#define SEARCH_DEPTH_MAX 64
+#define SEARCH_NODES_CHECK_INTERVAL 1024
+#define SEARCH_KILLERS_SIZE 2
+#define SEARCH_HISTORY_MAX (1 << 14)
+#define SEARCH_HISTORY_BONUS_MAX 1200
+#define SEARCH_PIECES_SIZE (PIECE_BK + 1)
+#define SEARCH_QUIETS_SIZE 64
+#define SEARCH_SKIP_SIZE 20
+#define SEARCH_MULTIPV_MAX 64
+
+typedef struct
+{
+    bool is_quiescence_enabled;
+    bool is_pruning_enabled;
+    bool is_extensions_enabled;
+    evaluation_t delta_margin;
+    uint64_t aspiration_depth;
+    evaluation_t aspiration_window;
+    uint64_t null_move_depth;
+    uint64_t null_move_reduction;
+    uint64_t null_move_verification_depth;
+    uint64_t lmr_depth;
+    size_t lmr_moves;
+    uint64_t futility_depth;
+    evaluation_t futility_margin;
+    uint64_t reverse_futility_depth;
+    evaluation_t reverse_futility_margin;
+    uint64_t razoring_depth;
+    evaluation_t razoring_margin;
+    uint64_t extensions_max;
+    uint64_t singular_depth;
+    evaluation_t singular_margin;
+    size_t multipv;
+    // in MB, the go mate solver's tree gives up beyond that
+    size_t solver_hash_size;
+    // zero-window probes at the root instead of aspiration windows
+    bool is_mtdf_enabled;
+    // monte carlo tree search instead of alpha-beta
+    bool is_mcts_enabled;
+    // in MB, the size of the shared tree
+    size_t mcts_hash_size;
+    double mcts_exploration;
+    size_t mcts_batch_size;
+} SearchParams;
+
+static const SearchParams SEARCH_PARAMS_DEFAULT =
+{
+    .is_quiescence_enabled = true,
+    .is_pruning_enabled    = true,
+    .is_extensions_enabled = true,
+    .delta_margin          = 200,
+    .aspiration_depth      = 4,
+    .aspiration_window     = 50,
+    .null_move_depth              = 2,
+    .null_move_reduction          = 2,
+    .null_move_verification_depth = 6,
+    .lmr_depth                    = 3,
+    .lmr_moves                    = 3,
+    .futility_depth               = 3,
+    .futility_margin              = 100,
+    .reverse_futility_depth       = 3,
+    .reverse_futility_margin      = 100,
+    .razoring_depth               = 2,
+    .razoring_margin              = 200,
+    .extensions_max               = 8,
+    .singular_depth               = 6,
+    .singular_margin              = 5,
+    .multipv                      = 1,
+    .solver_hash_size             = 64,
+    .is_mtdf_enabled              = false,
+    .is_mcts_enabled              = false,
+    .mcts_hash_size               = 256,
+    .mcts_exploration             = 1.5,
+    .mcts_batch_size              = 8,
+};
+
+typedef struct
+{
+    bool is_null_move;
+    // the move made at this ply, PIECE_NONE after a null move
+    piece_t moved_piece;
+    piece_t captured_piece;
+    int moved_to;
+    // extensions spent along the line leading here
+    uint64_t extensions;
+    // skipped by the singular extension search
+    Move excluded_move;
+    // the moves leading here all follow the previous iteration's pv
+    bool is_on_pv;
+    // inside a null move verification search, where null moves cut without being verified again
+    bool is_verifying;
+} SearchStackEntry;
+
+typedef struct
+{
+    Move move;
+    evaluation_t score;
+    Move pv[SEARCH_DEPTH_MAX + 1];
+    size_t pv_size;
+} SearchLine;
+
+// written by the owning thread only, other threads sum them up with relaxed atomic loads
+typedef struct
+{
+    uint64_t nodes;
+    uint64_t qnodes;
+    uint64_t tt_probes;
+    uint64_t tt_hits;
+    uint64_t beta_cutoffs;
+    uint64_t first_move_cutoffs;
+    // quiet moves tried up to and including each quiet cutoff, the measure of quiet ordering
+    uint64_t quiet_cutoffs;
+    uint64_t quiet_cutoff_moves;
+    uint64_t null_move_cutoffs;
+    uint64_t lmr_researches;
+    uint64_t extensions;
+    uint64_t seldepth;
+    uint64_t playouts;
+} SearchStats;
+
+typedef struct SearchThread SearchThread;
+
+typedef void (*search_callback_t)(void* arg, const SearchThread* thread);
+
+struct SearchThread
+{
+    // 0 is the main thread, helpers skip some depths
+    size_t index;
+    TranspositionTable* tt;
+    SearchParams params;
+    SearchLimits limits;
+    const bool* stop;
+    const bool* ponder;
+    bool is_pondering;
+    TimeManager time_manager;
+    // a search that follows another on the same move, like the one after the mate solver, keeps its clock
+    bool is_clock_started;
+    bool is_aborted;
+    // go nodes in a pool: every thread adds its nodes here too, so the budget holds for all of them
+    uint64_t* pool_nodes;
+    Move root_bestmove;
+    Move bestmove;
+    evaluation_t score;
+    uint64_t depth;
+    // multipv: line pv_index is searched with the moves of the lines before it excluded
+    size_t pv_index;
+    SearchLine lines[SEARCH_MULTIPV_MAX];
+    size_t lines_size;
+    SearchLine current_lines[SEARCH_MULTIPV_MAX];
+    // called after every finished iteration
+    search_callback_t on_iteration;
+    void* on_iteration_arg;
+    SearchStackEntry stack[SEARCH_DEPTH_MAX + 1];
+    // triangular pv table: row ply holds the best line found from that ply on
+    Move pv[SEARCH_DEPTH_MAX + 1][SEARCH_DEPTH_MAX + 1];
+    size_t pv_size[SEARCH_DEPTH_MAX + 1];
+    // move ordering
+    Move killers[SEARCH_DEPTH_MAX][SEARCH_KILLERS_SIZE];
+    int32_t history[2][BOARD_SIZE][BOARD_SIZE];
+    // indexed by the opponent's last move
+    Move countermoves[SEARCH_PIECES_SIZE][BOARD_SIZE];
+    // indexed by the move one or two plies back, then by the move in question
+    int16_t continuation_history[SEARCH_PIECES_SIZE][BOARD_SIZE][SEARCH_PIECES_SIZE][BOARD_SIZE];
+    SearchStats stats;
+};
+
+void search_init(void);
+void search_thread_init(SearchThread* thread, TranspositionTable* tt);
+void search_thread_new_search(SearchThread* thread);
+void search_start_clock(SearchThread* thread);
+
+evaluation_t search_negamax(SearchThread* thread, const BoardState* state, evaluation_t alpha, evaluation_t beta, uint64_t depth, uint64_t ply);
+evaluation_t search_quiescence(SearchThread* thread, const BoardState* state, evaluation_t alpha, evaluation_t beta, uint64_t ply);
+evaluation_t search_root(SearchThread* thread, const BoardState* state, uint64_t depth);
+evaluation_t search_aspiration(SearchThread* thread, const BoardState* state, uint64_t depth, evaluation_t previous);
+evaluation_t search_mtdf(SearchThread* thread, const BoardState* state, uint64_t depth, evaluation_t guess);
+evaluation_t search_iterative_deepening(SearchThread* thread, const BoardState* state, Move* bestmove);
+bool search_is_aborted(SearchThread* thread);
+void search_count_nodes(SearchThread* thread, uint64_t nodes);
+bool search_is_pondering(SearchThread* thread);
+
+void search_stats_add(SearchStats* total, const SearchStats* stats);
+
+#endif // SEARCH_H
+
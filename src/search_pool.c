@@ -0,0 +1,349 @@
+#include "search_pool.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// every thread votes for its best move, weighted by depth and by how much it
+// likes the move compared to the most pessimistic thread
+static const SearchThread* search_pool_vote(const SearchPool* pool)
+{
+    const SearchThread* main = &pool->workers[0]->thread;
+    evaluation_t score_min   = main->score;
+    for (size_t i=1; i<pool->workers_size; ++i)
+    {
+        const SearchThread* thread = &pool->workers[i]->thread;
+        if (thread->depth > 0 && thread->score < score_min)
+            score_min = thread->score;
+    }
+    const SearchThread* best = main;
+    int64_t best_votes       = 0;
+    for (size_t i=0; i<pool->workers_size; ++i)
+    {
+        const SearchThread* thread = &pool->workers[i]->thread;
+        if (thread->depth == 0 || !thread->bestmove.from)
+            continue;
+        int64_t votes = 0;
+        for (size_t j=0; j<pool->workers_size; ++j)
+        {
+            const SearchThread* voter = &pool->workers[j]->thread;
+            if (voter->depth > 0 && move_is_equal(&voter->bestmove, &thread->bestmove))
+                votes += (int64_t)(voter->score - score_min + 1) * (int64_t)voter->depth;
+        }
+        // a deeper thread wins ties, and a proven mate beats any vote
+        if (votes > best_votes
+            || (votes == best_votes && thread->depth > best->depth)
+            || (thread->score >= EVALUATION_MATE_BOUND && thread->score > best->score))
+        {
+            best       = thread;
+            best_votes = votes;
+        }
+    }
+    return best;
+}
+
+// the solver runs under the same stop flag, node budget and clock as any search thread,
+// except the clock is checked on every expansion since it counts nodes in batches. alone on
+// the main worker it hands the second half of the soft limit to the search that follows it
+static bool search_pool_is_solver_stopped(void* arg)
+{
+    SearchThread* thread = arg;
+    if (search_is_aborted(thread) || search_is_pondering(thread))
+        return thread->is_aborted;
+    if (time_manager_is_hard_expired(&thread->time_manager))
+        thread->is_aborted = true;
+    const TimeManager* tm = &thread->time_manager;
+    return thread->is_aborted
+        || (thread->index == 0 && tm->soft_limit > 0 && time_manager_elapsed(tm) >= tm->soft_limit / 2);
+}
+
+static void search_pool_count_solver_nodes(void* arg, uint64_t nodes)
+{
+    search_count_nodes(arg, nodes);
+}
+
+// go mate: proof-number search next to the alpha-beta threads, a proof ends the whole search
+static bool search_pool_solve_mate(SearchPool* pool, SearchThread* thread)
+{
+    search_start_clock(thread);
+    ProofNumberSearch pns;
+    proof_number_search_alloc(&pns, thread->params.solver_hash_size, search_pool_is_solver_stopped, search_pool_count_solver_nodes, thread);
+    SearchLine* line = &thread->lines[0];
+    const uint64_t mate_plies = proof_number_search_solve(&pns, &pool->state, pool->limits.mate, line->pv, &line->pv_size, SEARCH_DEPTH_MAX);
+    proof_number_search_free(&pns);
+    if (mate_plies == 0 || line->pv_size == 0)
+        return false;
+    line->move         = line->pv[0];
+    line->score        = EVALUATION_MATE - (evaluation_t)mate_plies;
+    thread->lines_size = 1;
+    thread->bestmove   = line->move;
+    thread->score      = line->score;
+    thread->depth      = mate_plies;
+    thread->stats.seldepth = mate_plies;
+    if (pool->iteration_callback)
+        pool->iteration_callback(pool->callback_arg, thread);
+    __atomic_store_n(&pool->stop, true, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void search_pool_search(SearchPool* pool, SearchThread* thread, Move* bestmove)
+{
+    if (thread->params.is_mcts_enabled)
+        mcts_search(thread, &pool->mcts, &pool->state, bestmove);
+    else
+        search_iterative_deepening(thread, &pool->state, bestmove);
+}
+
+static void search_pool_run(SearchWorker* worker)
+{
+    SearchPool* pool     = worker->pool;
+    SearchThread* thread = &worker->thread;
+    const bool is_main   = worker->index == 0;
+    search_thread_new_search(thread);
+    thread->index  = worker->index;
+    thread->tt     = pool->tt;
+    thread->params = pool->params;
+    // the main thread alone decides when time is up
+    thread->limits = is_main ? pool->limits : (SearchLimits){ .depth = pool->limits.depth, .nodes = pool->limits.nodes };
+    // go nodes budgets the whole pool
+    thread->pool_nodes = pool->limits.nodes ? &pool->nodes : NULL;
+    thread->stop   = is_main ? &pool->stop : &pool->helpers_stop;
+    thread->ponder = &pool->ponder;
+    // helpers only feed the tt, extra lines are the main thread's business
+    if (!is_main)
+        thread->params.multipv = 1;
+    thread->on_iteration     = is_main ? pool->iteration_callback : NULL;
+    thread->on_iteration_arg = pool->callback_arg;
+    Move moves[BOARD_STATE_MOVES_SIZE];
+    const size_t moves_size = board_state_get_legal_moves(&pool->state, moves, BOARD_STATE_MOVES_SIZE);
+    // the last worker of a go mate search runs the mate solver, the main worker only when it is alone
+    const bool is_solver = pool->limits.mate && worker->index == pool->workers_size - 1;
+    if (is_solver && !is_main)
+    {
+        if (moves_size > 0)
+            search_pool_solve_mate(pool, thread);
+        return;
+    }
+    if (!is_main)
+    {
+        if (moves_size > 0)
+            search_pool_search(pool, thread, NULL);
+        return;
+    }
+    if (moves_size > 0)
+    {
+        // an aborted first iteration still has to answer with a legal move
+        Move bestmove = moves[0];
+        // without a proof the main worker falls back to a normal search on the solver's clock
+        if (!is_solver || !search_pool_solve_mate(pool, thread))
+        {
+            search_pool_search(pool, thread, &bestmove);
+            thread->bestmove = bestmove;
+        }
+    }
+    // stop the helpers, then let every thread vote
+    __atomic_store_n(&pool->helpers_stop, true, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busy_size > 1)
+        pthread_cond_wait(&pool->idle_cond, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+    const SearchThread* best = (moves_size > 0) ? search_pool_vote(pool) : thread;
+    if (pool->callback)
+        pool->callback(pool->callback_arg, best);
+}
+
+static void* search_pool_worker_loop(void* arg)
+{
+    SearchWorker* worker = arg;
+    SearchPool* pool     = worker->pool;
+    uint64_t generation  = 0;
+    pthread_mutex_lock(&pool->mutex);
+    for (;;)
+    {
+        while (pool->generation == generation && !pool->is_quitting)
+            pthread_cond_wait(&pool->wake_cond, &pool->mutex);
+        if (pool->is_quitting)
+            break;
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+        search_pool_run(worker);
+        pthread_mutex_lock(&pool->mutex);
+        // the main worker waits for the helpers, stop waits for everyone
+        --pool->busy_size;
+        pthread_cond_broadcast(&pool->idle_cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+void search_pool_alloc(SearchPool* pool, size_t workers_size, TranspositionTable* tt)
+{
+    assert(pool != NULL);
+    assert(workers_size > 0);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake_cond, NULL);
+    pthread_cond_init(&pool->idle_cond, NULL);
+    pool->generation   = 0;
+    pool->busy_size    = 0;
+    pool->is_quitting  = false;
+    pool->tt           = tt;
+    pool->iteration_callback = NULL;
+    pool->callback     = NULL;
+    pool->callback_arg = NULL;
+    pool->stop         = false;
+    pool->helpers_stop = false;
+    pool->ponder       = false;
+    pool->nodes        = 0;
+    pool->mcts         = (simp_tree_mcts){0};
+    board_state_init(&pool->state);
+    pool->params       = SEARCH_PARAMS_DEFAULT;
+    pool->limits       = (SearchLimits){0};
+    pool->workers      = malloc(workers_size * sizeof(*pool->workers));
+    assert(pool->workers != NULL);
+    pool->workers_size = workers_size;
+    for (size_t i=0; i<workers_size; ++i)
+    {
+        // one allocation per worker keeps hot search state off shared cache lines
+        SearchWorker* worker = malloc(sizeof(SearchWorker));
+        assert(worker != NULL);
+        worker->pool  = pool;
+        worker->index = i;
+        search_thread_init(&worker->thread, tt);
+        pool->workers[i] = worker;
+        const int status = pthread_create(&worker->handle, NULL, search_pool_worker_loop, worker);
+        assert(status == 0);
+        (void)status;
+    }
+}
+
+void search_pool_free(SearchPool* pool)
+{
+    assert(pool != NULL);
+    assert(pool->workers != NULL);
+    search_pool_stop(pool);
+    pthread_mutex_lock(&pool->mutex);
+    pool->is_quitting = true;
+    pthread_cond_broadcast(&pool->wake_cond);
+    pthread_mutex_unlock(&pool->mutex);
+    for (size_t i=0; i<pool->workers_size; ++i)
+    {
+        pthread_join(pool->workers[i]->handle, NULL);
+        free(pool->workers[i]);
+    }
+    free(pool->workers);
+    if (pool->mcts.nodes)
+        simp_tree_mcts_free(&pool->mcts);
+    pool->workers      = NULL;
+    pool->workers_size = 0;
+    pthread_cond_destroy(&pool->idle_cond);
+    pthread_cond_destroy(&pool->wake_cond);
+    pthread_mutex_destroy(&pool->mutex);
+}
+
+void search_pool_resize(SearchPool* pool, size_t workers_size)
+{
+    assert(pool != NULL);
+    if (workers_size == pool->workers_size)
+        return;
+    TranspositionTable* tt = pool->tt;
+    search_pool_free(pool);
+    search_pool_alloc(pool, workers_size, tt);
+}
+
+void search_pool_start(SearchPool* pool, const BoardState* state, const SearchParams* params, const SearchLimits* limits,
+    search_callback_t iteration_callback, search_pool_callback_t callback, void* callback_arg)
+{
+    assert(pool != NULL);
+    assert(state != NULL);
+    assert(params != NULL);
+    assert(limits != NULL);
+    search_pool_stop(pool);
+    pthread_mutex_lock(&pool->mutex);
+    board_state_copy(state, &pool->state);
+    pool->params       = *params;
+    pool->limits       = *limits;
+    pool->iteration_callback = iteration_callback;
+    pool->callback     = callback;
+    pool->callback_arg = callback_arg;
+    pool->stop         = false;
+    pool->helpers_stop = false;
+    pool->ponder       = limits->is_ponder;
+    pool->nodes        = 0;
+    // the tree follows MCTSHash, and goes as soon as mcts is switched off
+    const size_t mcts_capacity = (params->mcts_hash_size << 20) / sizeof(simp_tree_mcts_node);
+    if (pool->mcts.nodes && (!params->is_mcts_enabled || pool->mcts.capacity != mcts_capacity))
+        simp_tree_mcts_free(&pool->mcts);
+    if (params->is_mcts_enabled)
+    {
+        if (!pool->mcts.nodes)
+            mcts_alloc(&pool->mcts, params->mcts_hash_size);
+        mcts_new_search(&pool->mcts);
+    }
+    pool->busy_size    = pool->workers_size;
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->wake_cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void search_pool_stop(SearchPool* pool)
+{
+    assert(pool != NULL);
+    __atomic_store_n(&pool->stop, true, __ATOMIC_RELAXED);
+    search_pool_wait(pool);
+}
+
+void search_pool_wait(SearchPool* pool)
+{
+    assert(pool != NULL);
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busy_size > 0)
+        pthread_cond_wait(&pool->idle_cond, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+bool search_pool_is_stopped(const SearchPool* pool)
+{
+    assert(pool != NULL);
+    return __atomic_load_n(&pool->stop, __ATOMIC_RELAXED);
+}
+
+void search_pool_ponderhit(SearchPool* pool)
+{
+    assert(pool != NULL);
+    __atomic_store_n(&pool->ponder, false, __ATOMIC_RELAXED);
+}
+
+bool search_pool_is_pondering(const SearchPool* pool)
+{
+    assert(pool != NULL);
+    return __atomic_load_n(&pool->ponder, __ATOMIC_RELAXED);
+}
+
+bool search_pool_is_searching(SearchPool* pool)
+{
+    assert(pool != NULL);
+    pthread_mutex_lock(&pool->mutex);
+    const bool is_searching = pool->busy_size > 0;
+    pthread_mutex_unlock(&pool->mutex);
+    return is_searching;
+}
+
+// safe while searching: every counter is read with a relaxed atomic load
+void search_pool_get_stats(const SearchPool* pool, SearchStats* stats)
+{
+    assert(pool != NULL);
+    assert(stats != NULL);
+    memset(stats, 0, sizeof(*stats));
+    for (size_t i=0; i<pool->workers_size; ++i)
+        search_stats_add(stats, &pool->workers[i]->thread.stats);
+}
+
+uint64_t search_pool_get_nodes(const SearchPool* pool)
+{
+    assert(pool != NULL);
+    uint64_t nodes = 0;
+    for (size_t i=0; i<pool->workers_size; ++i)
+        nodes += __atomic_load_n(&pool->workers[i]->thread.stats.nodes, __ATOMIC_RELAXED);
+    return nodes;
+}
+
@@ -0,0 +1,88 @@
+#ifndef SEARCH_POOL_H
+#define SEARCH_POOL_H
+
+// "Thread Pool", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Thread
+// "Lazy SMP", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Lazy_SMP
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "board_state.h"
+#include "transposition_table.h"
+#include "search.h"
+#include "proof_number_search.h"
+#include "mcts.h"
+
+typedef struct SearchPool SearchPool;
+
+// called on the main worker once its search is done, before the pool goes idle
+typedef search_callback_t search_pool_callback_t;
+
+#define SEARCH_POOL_CACHE_LINE_SIZE 64
+
+// padded on both sides, so no two workers' counters share a cache line
+typedef struct
+{
+    uint8_t padding_front[SEARCH_POOL_CACHE_LINE_SIZE];
+    SearchPool* pool;
+    size_t index;
+    pthread_t handle;
+    // survives between searches, so histories stay warm
+    SearchThread thread;
+    uint8_t padding_back[SEARCH_POOL_CACHE_LINE_SIZE];
+} SearchWorker;
+
+struct SearchPool
+{
+    SearchWorker** workers;
+    size_t workers_size;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake_cond;
+    pthread_cond_t idle_cond;
+    uint64_t generation;
+    size_t busy_size;
+    bool is_quitting;
+    // the current search, written while the pool is idle
+    BoardState state;
+    SearchParams params;
+    SearchLimits limits;
+    TranspositionTable* tt;
+    // the main worker reports every iteration, then its final result
+    search_callback_t iteration_callback;
+    search_pool_callback_t callback;
+    void* callback_arg;
+    // shared by all workers in mcts mode, allocated on first use and freed once mcts is off
+    simp_tree_mcts mcts;
+    // stop is raised from outside, helpers_stop by the main worker once it is done
+    bool stop;
+    bool helpers_stop;
+    // cleared by ponderhit
+    bool ponder;
+    // nodes of all workers, counted only under go nodes
+    uint64_t nodes;
+};
+
+#define SEARCH_POOL_WORKERS_DEFAULT 1
+#define SEARCH_POOL_WORKERS_MAX 256
+
+void search_pool_alloc(SearchPool* pool, size_t workers_size, TranspositionTable* tt);
+void search_pool_free(SearchPool* pool);
+void search_pool_resize(SearchPool* pool, size_t workers_size);
+
+void search_pool_start(SearchPool* pool, const BoardState* state, const SearchParams* params, const SearchLimits* limits,
+    search_callback_t iteration_callback, search_pool_callback_t callback, void* callback_arg);
+void search_pool_stop(SearchPool* pool);
+void search_pool_wait(SearchPool* pool);
+bool search_pool_is_stopped(const SearchPool* pool);
+void search_pool_ponderhit(SearchPool* pool);
+bool search_pool_is_pondering(const SearchPool* pool);
+bool search_pool_is_searching(SearchPool* pool);
+void search_pool_get_stats(const SearchPool* pool, SearchStats* stats);
+uint64_t search_pool_get_nodes(const SearchPool* pool);
+
+#endif // SEARCH_POOL_H
+
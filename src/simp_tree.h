@@ -1,13 +1,64 @@
 #ifndef SIMP_TREE_H
 #define SIMP_TREE_H
 
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SIMP_TREE_NONE UINT32_MAX
+
+// an arena of nodes that never moves: the children of a node are one contiguous block and
+// nodes refer to each other by index. reserving is lock-free, so several threads may grow one tree
 #define DEFINE_SIMP_TREE(type, name) \
     typedef struct \
     { \
         type data; \
-        struct name* parent; \
-        struct name* child; \
-    } name;
+        uint32_t parent; \
+        uint32_t first_child; \
+        uint16_t children_size; \
+    } name##_node; \
+    typedef struct \
+    { \
+        size_t size, capacity; \
+        name##_node* nodes; \
+    } name; \
+    static inline void name##_alloc(name* tree, size_t capacity) \
+    { \
+        assert(tree != NULL); \
+        assert(capacity < SIMP_TREE_NONE); \
+        tree->size     = 0; \
+        tree->nodes    = malloc(capacity * sizeof(*tree->nodes)); \
+        assert(tree->nodes != NULL); \
+        tree->capacity = capacity; \
+    } \
+    static inline void name##_free(name* tree) \
+    { \
+        assert(tree != NULL); \
+        assert(tree->nodes != NULL); \
+        free(tree->nodes); \
+        tree->nodes    = NULL; \
+        tree->size     = 0; \
+        tree->capacity = 0; \
+    } \
+    static inline void name##_clear(name* tree) \
+    { \
+        assert(tree != NULL); \
+        __atomic_store_n(&tree->size, 0, __ATOMIC_RELAXED); \
+    } \
+    static inline size_t name##_size(const name* tree) \
+    { \
+        assert(tree != NULL); \
+        const size_t size = __atomic_load_n(&tree->size, __ATOMIC_RELAXED); \
+        return (size < tree->capacity) ? size : tree->capacity; \
+    } \
+    static inline uint32_t name##_reserve(name* tree, size_t count) \
+    { \
+        assert(tree != NULL); \
+        const size_t first = __atomic_fetch_add(&tree->size, count, __ATOMIC_RELAXED); \
+        if (first + count > tree->capacity) \
+            return SIMP_TREE_NONE; \
+        return (uint32_t)first; \
+    }
 
 #endif // SIMP_TREE_H
 
@@ -0,0 +1,87 @@
+#include "time_manager.h"
+
+#include <assert.h>
+
+#include "utils.h"
+
+void time_manager_init(TimeManager* tm, uint64_t time, uint64_t increment, uint64_t movestogo, uint64_t movetime, uint64_t overhead, bool is_ponder_enabled)
+{
+    assert(tm != NULL);
+    tm->start_time        = time_now_seconds();
+    tm->optimum           = 0;
+    tm->soft_limit        = 0;
+    tm->hard_limit        = 0;
+    tm->previous_bestmove = (Move){0};
+    tm->previous_score    = 0;
+    tm->stability         = 0;
+    if (movetime)
+    {
+        // a fixed budget leaves nothing to plan
+        const double budget = (movetime > overhead) ? (double)(movetime - overhead) : 1.0;
+        tm->optimum    = budget;
+        tm->soft_limit = budget;
+        tm->hard_limit = budget;
+    }
+    else if (time)
+    {
+        const double available = (time > overhead) ? (double)(time - overhead) : 1.0;
+        uint64_t moves = movestogo ? movestogo : TIME_MANAGER_MOVES_TO_GO_DEFAULT;
+        if (moves > TIME_MANAGER_MOVES_TO_GO_MAX)
+            moves = TIME_MANAGER_MOVES_TO_GO_MAX;
+        const double maximum = TIME_MANAGER_CLOCK_SHARE_MAX * available;
+        const double optimum = (available / moves + 0.75 * increment) * (is_ponder_enabled ? TIME_MANAGER_PONDER_FACTOR : 1.0);
+        tm->optimum    = (optimum < maximum) ? optimum : maximum;
+        tm->hard_limit = (TIME_MANAGER_HARD_FACTOR * optimum < maximum) ? TIME_MANAGER_HARD_FACTOR * optimum : maximum;
+        tm->soft_limit = tm->optimum;
+    }
+}
+
+// called after every finished iteration: a stable best move shrinks the soft limit,
+// a changing one or a dropping score grows it, always within the hard limit
+void time_manager_update(TimeManager* tm, const Move* bestmove, evaluation_t score)
+{
+    assert(tm != NULL);
+    assert(bestmove != NULL);
+    const bool is_first = tm->previous_bestmove.from == 0;
+    if (!is_first && move_is_equal(bestmove, &tm->previous_bestmove))
+    {
+        if (tm->stability < TIME_MANAGER_STABILITY_MAX)
+            ++tm->stability;
+    }
+    else
+    {
+        tm->stability = 0;
+    }
+    evaluation_t drop = is_first ? 0 : tm->previous_score - score;
+    if (drop < 0)
+        drop = 0;
+    if (drop > TIME_MANAGER_SCORE_DROP)
+        drop = TIME_MANAGER_SCORE_DROP;
+    tm->previous_bestmove = *bestmove;
+    tm->previous_score    = score;
+    if (tm->optimum == tm->hard_limit)
+        return;
+    const double stability_factor = 1.4 - 0.08 * tm->stability;
+    const double drop_factor      = 1.0 + (double)drop / TIME_MANAGER_SCORE_DROP;
+    const double soft_limit       = tm->optimum * stability_factor * drop_factor;
+    tm->soft_limit = (soft_limit < tm->hard_limit) ? soft_limit : tm->hard_limit;
+}
+
+double time_manager_elapsed(const TimeManager* tm)
+{
+    assert(tm != NULL);
+    return 1000.0 * (time_now_seconds() - tm->start_time);
+}
+
+bool time_manager_is_soft_expired(const TimeManager* tm)
+{
+    assert(tm != NULL);
+    return tm->soft_limit > 0 && time_manager_elapsed(tm) >= tm->soft_limit;
+}
+
+bool time_manager_is_hard_expired(const TimeManager* tm)
+{
+    assert(tm != NULL);
+    return tm->hard_limit > 0 && time_manager_elapsed(tm) >= tm->hard_limit;
+}
+
@@ -0,0 +1,45 @@
+#ifndef TIME_MANAGER_H
+#define TIME_MANAGER_H
+
+// "Time Management", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Time_Management
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "board_state.h"
+
+// all times in milliseconds, a limit of 0 means unlimited
+typedef struct
+{
+    double start_time;
+    double optimum;
+    double soft_limit;
+    double hard_limit;
+    Move previous_bestmove;
+    evaluation_t previous_score;
+    uint64_t stability;
+} TimeManager;
+
+#define TIME_MANAGER_MOVES_TO_GO_DEFAULT 30
+#define TIME_MANAGER_MOVES_TO_GO_MAX 50
+#define TIME_MANAGER_MOVE_OVERHEAD_DEFAULT 10
+#define TIME_MANAGER_STABILITY_MAX 10
+
+// never plan to use more than this share of the clock on one move
+static const double TIME_MANAGER_CLOCK_SHARE_MAX = 0.8;
+// the hard limit allows overrunning the optimum by this factor
+static const double TIME_MANAGER_HARD_FACTOR = 4.0;
+// a score drop of this many centipawns doubles the soft limit
+static const evaluation_t TIME_MANAGER_SCORE_DROP = 100;
+// with pondering on, ponder hits hand time back, so the optimum may grow by this factor
+static const double TIME_MANAGER_PONDER_FACTOR = 1.25;
+
+void time_manager_init(TimeManager* tm, uint64_t time, uint64_t increment, uint64_t movestogo, uint64_t movetime, uint64_t overhead, bool is_ponder_enabled);
+void time_manager_update(TimeManager* tm, const Move* bestmove, evaluation_t score);
+double time_manager_elapsed(const TimeManager* tm);
+bool time_manager_is_soft_expired(const TimeManager* tm);
+bool time_manager_is_hard_expired(const TimeManager* tm);
+
+#endif // TIME_MANAGER_H
+
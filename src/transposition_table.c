@@ -0,0 +1,174 @@
+#include "transposition_table.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+// 64 bits: move (16) | score (16) | depth (8) | bound (2) | age (6)
+#define DATA_MOVE_SHIFT  0
+#define DATA_SCORE_SHIFT 16
+#define DATA_DEPTH_SHIFT 32
+#define DATA_BOUND_SHIFT 40
+#define DATA_AGE_SHIFT   42
+
+// mates are stored relative to the entry rather than the root,
+// so the same position reached at another ply reads the right distance
+static int16_t score_to_packed(evaluation_t score, uint64_t ply)
+{
+    assert(score >= -EVALUATION_INFINITE && score <= EVALUATION_INFINITE);
+    if (score >= EVALUATION_MATE_BOUND && score < EVALUATION_INFINITE)
+        score += (evaluation_t)ply;
+    else if (score <= -EVALUATION_MATE_BOUND && score > -EVALUATION_INFINITE)
+        score -= (evaluation_t)ply;
+    return (int16_t)score;
+}
+
+static evaluation_t packed_to_score(int16_t packed, uint64_t ply)
+{
+    evaluation_t score = packed;
+    if (score >= EVALUATION_MATE_BOUND && score < EVALUATION_INFINITE)
+        score -= (evaluation_t)ply;
+    else if (score <= -EVALUATION_MATE_BOUND && score > -EVALUATION_INFINITE)
+        score += (evaluation_t)ply;
+    return score;
+}
+
+static uint64_t data_pack(const Move* move, int16_t score, uint8_t depth, transposition_table_bound_t bound, uint8_t age)
+{
+    return (uint64_t)move_to_packed(move) << DATA_MOVE_SHIFT
+        | (uint64_t)(uint16_t)score << DATA_SCORE_SHIFT
+        | (uint64_t)depth << DATA_DEPTH_SHIFT
+        | (uint64_t)(bound & 0x3) << DATA_BOUND_SHIFT
+        | (uint64_t)(age & TRANSPOSITION_TABLE_AGE_MASK) << DATA_AGE_SHIFT;
+}
+
+static uint16_t data_move(uint64_t data)  { return (uint16_t)(data >> DATA_MOVE_SHIFT); }
+static int16_t data_score(uint64_t data)  { return (int16_t)(uint16_t)(data >> DATA_SCORE_SHIFT); }
+static uint8_t data_depth(uint64_t data)  { return (uint8_t)(data >> DATA_DEPTH_SHIFT); }
+static uint8_t data_bound(uint64_t data)  { return (uint8_t)((data >> DATA_BOUND_SHIFT) & 0x3); }
+static uint8_t data_age(uint64_t data)    { return (uint8_t)((data >> DATA_AGE_SHIFT) & TRANSPOSITION_TABLE_AGE_MASK); }
+
+void transposition_table_alloc(TranspositionTable* tt, size_t size_mb)
+{
+    assert(tt != NULL);
+    assert(size_mb > 0);
+    // round down to a power of two so the bucket index is a mask
+    size_t buckets_size = 1;
+    while (2 * buckets_size * sizeof(TranspositionTableBucket) <= size_mb * TRANSPOSITION_TABLE_MB)
+        buckets_size *= 2;
+    // align buckets to cache lines by hand, aligned_alloc is C11
+    tt->allocation = malloc(buckets_size * sizeof(TranspositionTableBucket) + TRANSPOSITION_TABLE_CACHE_LINE_SIZE - 1);
+    assert(tt->allocation != NULL);
+    const uintptr_t address = (uintptr_t)tt->allocation;
+    tt->buckets      = (TranspositionTableBucket*)((address + TRANSPOSITION_TABLE_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(TRANSPOSITION_TABLE_CACHE_LINE_SIZE - 1));
+    tt->buckets_size = buckets_size;
+    tt->age          = 0;
+    transposition_table_clear(tt);
+}
+
+void transposition_table_free(TranspositionTable* tt)
+{
+    assert(tt != NULL);
+    assert(tt->allocation != NULL);
+    free(tt->allocation);
+    tt->allocation   = NULL;
+    tt->buckets      = NULL;
+    tt->buckets_size = 0;
+}
+
+void transposition_table_resize(TranspositionTable* tt, size_t size_mb)
+{
+    assert(tt != NULL);
+    transposition_table_free(tt);
+    transposition_table_alloc(tt, size_mb);
+}
+
+void transposition_table_clear(TranspositionTable* tt)
+{
+    assert(tt != NULL);
+    memset(tt->buckets, 0, tt->buckets_size * sizeof(TranspositionTableBucket));
+    tt->age = 0;
+}
+
+void transposition_table_new_search(TranspositionTable* tt)
+{
+    assert(tt != NULL);
+    tt->age = (tt->age + 1) & TRANSPOSITION_TABLE_AGE_MASK;
+}
+
+// permille of a sample of entries written during the current search, as reported by uci
+uint64_t transposition_table_hashfull(const TranspositionTable* tt)
+{
+    assert(tt != NULL);
+    uint64_t used = 0, sampled = 0;
+    for (size_t i=0; i<tt->buckets_size && sampled<TRANSPOSITION_TABLE_HASHFULL_SAMPLE; ++i)
+        for (size_t j=0; j<TRANSPOSITION_TABLE_BUCKET_SIZE; ++j, ++sampled)
+        {
+            const uint64_t data = __atomic_load_n(&tt->buckets[i].entries[j].data, __ATOMIC_RELAXED);
+            if (data != 0 && data_age(data) == tt->age)
+                ++used;
+        }
+    return sampled ? 1000 * used / sampled : 0;
+}
+
+bool transposition_table_probe(const TranspositionTable* tt, uint64_t hash, uint64_t ply, TranspositionTableRecord* record)
+{
+    assert(tt != NULL);
+    assert(record != NULL);
+    const TranspositionTableBucket* bucket = &tt->buckets[hash & (tt->buckets_size - 1)];
+    for (size_t i=0; i<TRANSPOSITION_TABLE_BUCKET_SIZE; ++i)
+    {
+        const TranspositionTableEntry* entry = &bucket->entries[i];
+        const uint64_t key  = __atomic_load_n(&entry->key, __ATOMIC_RELAXED);
+        const uint64_t data = __atomic_load_n(&entry->data, __ATOMIC_RELAXED);
+        if ((key ^ data) != hash || data == 0)
+            continue;
+        record->move  = packed_to_move(data_move(data));
+        record->score = packed_to_score(data_score(data), ply);
+        record->depth = data_depth(data);
+        record->bound = data_bound(data);
+        return true;
+    }
+    return false;
+}
+
+void transposition_table_store(TranspositionTable* tt, uint64_t hash, uint64_t ply, const Move* move, evaluation_t score, uint8_t depth, transposition_table_bound_t bound)
+{
+    assert(tt != NULL);
+    assert(move != NULL);
+    TranspositionTableBucket* bucket = &tt->buckets[hash & (tt->buckets_size - 1)];
+    TranspositionTableEntry* replace = NULL;
+    int replace_value = 0;
+    Move stored_move  = *move;
+    for (size_t i=0; i<TRANSPOSITION_TABLE_BUCKET_SIZE; ++i)
+    {
+        TranspositionTableEntry* entry = &bucket->entries[i];
+        const uint64_t key  = __atomic_load_n(&entry->key, __ATOMIC_RELAXED);
+        const uint64_t data = __atomic_load_n(&entry->data, __ATOMIC_RELAXED);
+        if ((key ^ data) == hash && data != 0)
+        {
+            // same position: a shallower bound from this search, like a verification or
+            // quiescence probe, must not evict the deeper result
+            if (bound != TRANSPOSITION_TABLE_BOUND_EXACT && depth < data_depth(data) && data_age(data) == tt->age)
+                return;
+            // keep the old move if we have none to offer
+            if (move_to_packed(move) == MOVE_PACKED_NONE)
+                stored_move = packed_to_move(data_move(data));
+            replace = entry;
+            break;
+        }
+        // prefer shallow entries from old searches
+        const int age_distance = (tt->age - data_age(data)) & TRANSPOSITION_TABLE_AGE_MASK;
+        const int value        = (data == 0) ? INT_MIN : data_depth(data) - TRANSPOSITION_TABLE_AGE_WEIGHT * age_distance;
+        if (!replace || value < replace_value)
+        {
+            replace       = entry;
+            replace_value = value;
+        }
+    }
+    const uint64_t data = data_pack(&stored_move, score_to_packed(score, ply), depth, bound, tt->age);
+    __atomic_store_n(&replace->key, hash ^ data, __ATOMIC_RELAXED);
+    __atomic_store_n(&replace->data, data, __ATOMIC_RELAXED);
+}
+
@@ -0,0 +1,70 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+// "Transposition Table", _Chessprogramming wiki_
+// https://www.chessprogramming.org/Transposition_Table
+// "A lockless transposition-table implementation for parallel search", Hyatt, Mann
+// https://craftychess.com/hyatt/hashing.html
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "board_state.h"
+
+typedef enum
+{
+    TRANSPOSITION_TABLE_BOUND_NONE,
+    TRANSPOSITION_TABLE_BOUND_UPPER,
+    TRANSPOSITION_TABLE_BOUND_LOWER,
+    TRANSPOSITION_TABLE_BOUND_EXACT,
+} transposition_table_bound_t;
+
+// key is stored as hash ^ data, so a torn write by another thread fails the key check
+typedef struct
+{
+    uint64_t key;
+    uint64_t data;
+} TranspositionTableEntry;
+
+#define TRANSPOSITION_TABLE_CACHE_LINE_SIZE 64
+#define TRANSPOSITION_TABLE_BUCKET_SIZE (TRANSPOSITION_TABLE_CACHE_LINE_SIZE / sizeof(TranspositionTableEntry))
+
+typedef struct
+{
+    TranspositionTableEntry entries[TRANSPOSITION_TABLE_BUCKET_SIZE];
+} TranspositionTableBucket;
+
+typedef struct
+{
+    void* allocation;
+    TranspositionTableBucket* buckets;
+    size_t buckets_size;
+    uint8_t age;
+} TranspositionTable;
+
+typedef struct
+{
+    Move move;
+    evaluation_t score;
+    uint8_t depth;
+    transposition_table_bound_t bound;
+} TranspositionTableRecord;
+
+#define TRANSPOSITION_TABLE_MB (1ULL << 20)
+#define TRANSPOSITION_TABLE_AGE_MASK 0x3F
+#define TRANSPOSITION_TABLE_AGE_WEIGHT 8
+#define TRANSPOSITION_TABLE_HASHFULL_SAMPLE 1000
+
+void transposition_table_alloc(TranspositionTable* tt, size_t size_mb);
+void transposition_table_free(TranspositionTable* tt);
+void transposition_table_resize(TranspositionTable* tt, size_t size_mb);
+void transposition_table_clear(TranspositionTable* tt);
+void transposition_table_new_search(TranspositionTable* tt);
+uint64_t transposition_table_hashfull(const TranspositionTable* tt);
+
+bool transposition_table_probe(const TranspositionTable* tt, uint64_t hash, uint64_t ply, TranspositionTableRecord* record);
+void transposition_table_store(TranspositionTable* tt, uint64_t hash, uint64_t ply, const Move* move, evaluation_t score, uint8_t depth, transposition_table_bound_t bound);
+
+#endif // TRANSPOSITION_TABLE_H
+
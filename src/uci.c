@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200112L
 #include "uci.h"
 
 #include <stdio.h>
@@ -5,6 +6,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <math.h>
+#include <poll.h>
 
 #include "utils.h"
 #include "dyn_array.h"
@@ -13,8 +15,14 @@ void uci_state_init_alloc(UCIState* uci)
 {
     assert(uci != NULL);
     board_state_init(&uci->state);
-    dyn_array_pthread_alloc(&uci->threads, 8);
+    transposition_table_alloc(&uci->tt, UCI_OPTION_HASH_DEFAULT);
+    search_pool_alloc(&uci->pool, UCI_OPTION_THREADS_DEFAULT, &uci->tt);
     uci->search_mode = UCI_SEARCH_MODE_STOP;
+    uci->params      = SEARCH_PARAMS_DEFAULT;
+    uci->limits      = (SearchLimits){0};
+    uci->move_overhead = TIME_MANAGER_MOVE_OVERHEAD_DEFAULT;
+    uci->is_ponder_enabled = false;
+    uci->search_start  = 0;
     uci->debug_flag  = false;
 }
 
@@ -28,6 +36,7 @@ void uci_run_dialog(void)
         printf("\n");
         dyn_array_char buffer;
         dyn_array_char_alloc(&buffer, UCI_BUFFER_SIZE);
+        uci_wait_for_input(&uci);
         int c = getc(stdin);
         for (; c && c != '\n' && c != EOF; c = getc(stdin))
             dyn_array_char_append(&buffer, (char)c);
@@ -47,7 +56,7 @@ void uci_run_dialog(void)
         else if (strcmp(cmd, "isready") == 0)
             uci_cmd_isready();
         else if (strcmp(cmd, "setoption") == 0)
-            assert(false && "NOT IMPLEMENTED");
+            uci_cmd_setoption(&uci, tokens_in, tokens_in_size);
         else if (strcmp(cmd, "position") == 0)
             uci_cmd_position(&uci, tokens_in, tokens_in_size);
         else if (strcmp(cmd, "go") == 0)
@@ -55,20 +64,25 @@ void uci_run_dialog(void)
         else if (strcmp(cmd, "stop") == 0)
             uci_cmd_stop(&uci);
         else if (strcmp(cmd, "ponderhit") == 0)
-            assert(false && "NOT IMPLEMENTED");
+            uci_cmd_ponderhit(&uci);
         else if (strcmp(cmd, "quit") == 0)
+        {
+            uci_cmd_stop(&uci);
             break;
+        }
         for (size_t i=0; i<tokens.size; ++i)
             free(tokens.data[i]);
         dyn_array_char_free(&buffer);
         dyn_array_char_ptr_free(&tokens);
     }
-    dyn_array_pthread_free(&uci.threads);
+    search_pool_free(&uci.pool);
+    transposition_table_free(&uci.tt);
 }
 
 void uci_cmd_uci(void)
 {
     uci_send_id();
+    uci_send_options();
     uci_send_uciok();
 }
 
@@ -88,16 +102,117 @@ void uci_cmd_isready(void)
     uci_send_readyok();
 }
 
+void uci_cmd_setoption(UCIState* uci, char** tokens, size_t tokens_size)
+{
+    assert(uci != NULL);
+    assert(tokens != NULL);
+    // the search reads the options and the hash table
+    uci_cmd_stop(uci);
+    // setoption name <id> [value <x>], where <id> may contain spaces
+    char name[UCI_BUFFER_SIZE] = {0};
+    const char* value = NULL;
+    size_t i = 0;
+    if (i >= tokens_size || strcmp(tokens[i++], "name") != 0)
+        return;
+    for (; i<tokens_size && strcmp(tokens[i], "value") != 0; ++i)
+    {
+        if (name[0] != '\0')
+            strncat(name, " ", UCI_BUFFER_SIZE - strlen(name) - 1);
+        strncat(name, tokens[i], UCI_BUFFER_SIZE - strlen(name) - 1);
+    }
+    if (i+1 < tokens_size)
+        value = tokens[i+1];
+    if (strcmp(name, "Hash") == 0 && value)
+    {
+        int size_mb = atoi(value);
+        if (size_mb < UCI_OPTION_HASH_MIN) size_mb = UCI_OPTION_HASH_MIN;
+        if (size_mb > UCI_OPTION_HASH_MAX) size_mb = UCI_OPTION_HASH_MAX;
+        transposition_table_resize(&uci->tt, size_mb);
+    }
+    else if (strcmp(name, "Threads") == 0 && value)
+    {
+        int threads = atoi(value);
+        if (threads < 1) threads = 1;
+        if (threads > UCI_OPTION_THREADS_MAX) threads = UCI_OPTION_THREADS_MAX;
+        search_pool_resize(&uci->pool, threads);
+    }
+    else if (strcmp(name, "Clear Hash") == 0)
+    {
+        transposition_table_clear(&uci->tt);
+    }
+    // margins are given in centipawns
+    else if (strcmp(name, "FutilityMargin") == 0 && value)
+    {
+        uci->params.futility_margin = atoi(value);
+    }
+    else if (strcmp(name, "ReverseFutilityMargin") == 0 && value)
+    {
+        uci->params.reverse_futility_margin = atoi(value);
+    }
+    else if (strcmp(name, "RazoringMargin") == 0 && value)
+    {
+        uci->params.razoring_margin = atoi(value);
+    }
+    else if (strcmp(name, "Move Overhead") == 0 && value)
+    {
+        int overhead = atoi(value);
+        if (overhead < 0) overhead = 0;
+        if (overhead > UCI_OPTION_MOVE_OVERHEAD_MAX) overhead = UCI_OPTION_MOVE_OVERHEAD_MAX;
+        uci->move_overhead = overhead;
+    }
+    else if (strcmp(name, "Ponder") == 0 && value)
+    {
+        uci->is_ponder_enabled = strcmp(value, "true") == 0;
+    }
+    else if (strcmp(name, "UseMCTS") == 0 && value)
+    {
+        uci->params.is_mcts_enabled = strcmp(value, "true") == 0;
+    }
+    else if (strcmp(name, "MCTSHash") == 0 && value)
+    {
+        int size_mb = atoi(value);
+        if (size_mb < UCI_OPTION_HASH_MIN) size_mb = UCI_OPTION_HASH_MIN;
+        if (size_mb > UCI_OPTION_HASH_MAX) size_mb = UCI_OPTION_HASH_MAX;
+        uci->params.mcts_hash_size = size_mb;
+    }
+    else if (strcmp(name, "SolverHash") == 0 && value)
+    {
+        int size_mb = atoi(value);
+        if (size_mb < UCI_OPTION_HASH_MIN) size_mb = UCI_OPTION_HASH_MIN;
+        if (size_mb > UCI_OPTION_HASH_MAX) size_mb = UCI_OPTION_HASH_MAX;
+        uci->params.solver_hash_size = size_mb;
+    }
+    else if (strcmp(name, "UseMTDf") == 0 && value)
+    {
+        uci->params.is_mtdf_enabled = strcmp(value, "true") == 0;
+    }
+    else if (strcmp(name, "MultiPV") == 0 && value)
+    {
+        int multipv = atoi(value);
+        if (multipv < 1) multipv = 1;
+        if (multipv > UCI_OPTION_MULTIPV_MAX) multipv = UCI_OPTION_MULTIPV_MAX;
+        uci->params.multipv = multipv;
+    }
+}
+
 void uci_cmd_position(UCIState* uci, char** tokens, size_t tokens_size)
 {
     assert(uci != NULL);
     assert(tokens != NULL);
+    uci_cmd_stop(uci);
     size_t moves_token_idx = 1;
     BoardState* state = &uci->state;
     if (strcmp(tokens[0], "fen") == 0)
     {
-        moves_token_idx = 2;
-        board_state_set_fen_string(state, tokens[1], BOARD_STATE_SET_FEN_STRING_SIZE);
+        // the fen is split over up to six tokens
+        char fen_str[BOARD_STATE_SET_FEN_STRING_SIZE] = {0};
+        for (moves_token_idx=1; moves_token_idx<tokens_size && strcmp(tokens[moves_token_idx], "moves") != 0; ++moves_token_idx)
+        {
+            if (moves_token_idx > 1)
+                strncat(fen_str, " ", BOARD_STATE_SET_FEN_STRING_SIZE - strlen(fen_str) - 1);
+            strncat(fen_str, tokens[moves_token_idx], BOARD_STATE_SET_FEN_STRING_SIZE - strlen(fen_str) - 1);
+        }
+        board_state_set_fen_string(state, fen_str, strlen(fen_str));
     }
     else if (strcmp(tokens[0], "startpos") == 0)
     {
@@ -121,6 +236,12 @@ void uci_cmd_position(UCIState* uci, char** tokens, size_t tokens_size)
 void uci_cmd_go(UCIState* uci, char** tokens, size_t tokens_size)
 {
     assert(uci != NULL);
+    uci_cmd_stop(uci);
+    uci->limits = (SearchLimits){0};
+    uci->limits.move_overhead     = uci->move_overhead;
+    uci->limits.is_ponder_enabled = uci->is_ponder_enabled;
+    uci->search_mode = UCI_SEARCH_MODE_STOP;
+    const bool is_white = board_state_is_white(&uci->state);
     for (size_t i=0; i<tokens_size; ++i)
     {
         char* token = tokens[i];
@@ -130,66 +251,97 @@ void uci_cmd_go(UCIState* uci, char** tokens, size_t tokens_size)
         }
         else if (strcmp(token, "ponder") == 0)
         {
-            assert(false && "NOT IMPLEMENTED");
-        }
-        else if (strcmp(token, "wtime") == 0)
-        {
-            assert(false && "NOT IMPLEMENTED");
-        }
-        else if (strcmp(token, "btime") == 0)
-        {
-            assert(false && "NOT IMPLEMENTED");
+            uci->limits.is_ponder = true;
         }
-        else if (strcmp(token, "winc") == 0)
+        // only our own clock matters
+        else if (strcmp(token, "wtime") == 0 || strcmp(token, "btime") == 0)
         {
-            assert(false && "NOT IMPLEMENTED");
+            if (++i >= tokens_size)
+                break;
+            // a flagged clock may show up as zero or negative
+            if (is_white == (token[0] == 'w'))
+                uci->limits.time = (atoi(tokens[i]) > 0) ? atoi(tokens[i]) : 1;
+            if (uci->search_mode == UCI_SEARCH_MODE_STOP)
+                uci->search_mode = UCI_SEARCH_MODE_CLOCK;
         }
-        else if (strcmp(token, "binc") == 0)
+        else if (strcmp(token, "winc") == 0 || strcmp(token, "binc") == 0)
         {
-            assert(false && "NOT IMPLEMENTED");
+            if (++i >= tokens_size)
+                break;
+            if (is_white == (token[0] == 'w') && atoi(tokens[i]) > 0)
+                uci->limits.increment = atoi(tokens[i]);
         }
         else if (strcmp(token, "movestogo") == 0)
         {
-            assert(false && "NOT IMPLEMENTED");
+            if (++i >= tokens_size)
+                break;
+            if (atoi(tokens[i]) > 0)
+                uci->limits.movestogo = atoi(tokens[i]);
         }
         else if (strcmp(token, "depth") == 0)
         {
             if (++i >= tokens_size)
                 break;
-            uci->depth = atoi(tokens[i]); // TODO handle failure
-            uci->search_mode = UCI_SEARCH_MODE_DEPTH;
+            uci->limits.depth = atoi(tokens[i]); // TODO handle failure
+            uci->search_mode  = UCI_SEARCH_MODE_DEPTH;
         }
         else if (strcmp(token, "nodes") == 0)
         {
-            assert(false && "NOT IMPLEMENTED");
+            if (++i >= tokens_size)
+                break;
+            // budgets beyond int range are common in node-limited matches
+            uci->limits.nodes = strtoull(tokens[i], NULL, 10);
+            if (uci->search_mode == UCI_SEARCH_MODE_STOP)
+                uci->search_mode = UCI_SEARCH_MODE_NODES;
         }
         else if (strcmp(token, "mate") == 0)
         {
-            assert(false && "NOT IMPLEMENTED");
+            if (++i >= tokens_size)
+                break;
+            if (atoi(tokens[i]) > 0)
+                uci->limits.mate = atoi(tokens[i]);
+            if (uci->search_mode == UCI_SEARCH_MODE_STOP)
+                uci->search_mode = UCI_SEARCH_MODE_MATE;
         }
         else if (strcmp(token, "movetime") == 0)
         {
-            assert(false && "NOT IMPLEMENTED");
+            if (++i >= tokens_size)
+                break;
+            // an unreadable or non-positive time leaves the search unlimited by it
+            if (atoi(tokens[i]) <= 0)
+                continue;
+            uci->limits.movetime = atoi(tokens[i]);
+            if (uci->search_mode != UCI_SEARCH_MODE_DEPTH)
+                uci->search_mode = UCI_SEARCH_MODE_MOVETIME;
         }
         else if (strcmp(token, "infinite") == 0)
         {
-            assert(false && "NOT IMPLEMENTED");
             uci->search_mode = UCI_SEARCH_MODE_INFINITE;
         }
     }
-    pthread_create(&uci->threads.data[0], NULL, uci_search_loop, uci);
-    pthread_join(uci->threads.data[0], NULL);
-    uci_send_bestmove(uci);
+    // a bare go searches until stopped
+    if (uci->search_mode == UCI_SEARCH_MODE_STOP)
+        uci->search_mode = UCI_SEARCH_MODE_INFINITE;
+    else if (uci->limits.is_ponder)
+        uci->search_mode = UCI_SEARCH_MODE_PONDER;
+    transposition_table_new_search(&uci->tt);
+    uci->search_start = time_now_seconds();
+    // the main worker sends bestmove itself, the dialog keeps reading commands
+    search_pool_start(&uci->pool, &uci->state, &uci->params, &uci->limits, uci_search_iteration, uci_search_finish, uci);
 }
 
 void uci_cmd_stop(UCIState* uci)
 {
     assert(uci != NULL);
-    assert(uci->search_mode != UCI_SEARCH_MODE_STOP);
+    search_pool_stop(&uci->pool);
     uci->search_mode = UCI_SEARCH_MODE_STOP;
-    char bestmove_str[MOVE_TO_STRING_SIZE];
-    move_to_string(&uci->bestmove, bestmove_str, MOVE_TO_STRING_SIZE);
-    printf("bestmove %s\n", bestmove_str);
+}
+
+// the opponent played the expected move: keep searching, now on our clock
+void uci_cmd_ponderhit(UCIState* uci)
+{
+    assert(uci != NULL);
+    search_pool_ponderhit(&uci->pool);
 }
 
 void uci_send_id(void)
@@ -198,6 +350,34 @@ void uci_send_id(void)
     printf("id author " UCI_CNOOBDOGG_AUTHOR "\n");
 }
 
+void uci_send_options(void)
+{
+    printf("option name Hash type spin default %d min %d max %d\n",
+        UCI_OPTION_HASH_DEFAULT, UCI_OPTION_HASH_MIN, UCI_OPTION_HASH_MAX);
+    printf("option name Threads type spin default %d min 1 max %d\n",
+        UCI_OPTION_THREADS_DEFAULT, UCI_OPTION_THREADS_MAX);
+    printf("option name Ponder type check default false\n");
+    printf("option name Clear Hash type button\n");
+    printf("option name FutilityMargin type spin default %d min 0 max %d\n",
+        (int)SEARCH_PARAMS_DEFAULT.futility_margin, UCI_OPTION_MARGIN_MAX);
+    printf("option name ReverseFutilityMargin type spin default %d min 0 max %d\n",
+        (int)SEARCH_PARAMS_DEFAULT.reverse_futility_margin, UCI_OPTION_MARGIN_MAX);
+    printf("option name RazoringMargin type spin default %d min 0 max %d\n",
+        (int)SEARCH_PARAMS_DEFAULT.razoring_margin, UCI_OPTION_MARGIN_MAX);
+    printf("option name Move Overhead type spin default %d min 0 max %d\n",
+        TIME_MANAGER_MOVE_OVERHEAD_DEFAULT, UCI_OPTION_MOVE_OVERHEAD_MAX);
+    printf("option name MultiPV type spin default %d min 1 max %d\n",
+        (int)SEARCH_PARAMS_DEFAULT.multipv, UCI_OPTION_MULTIPV_MAX);
+    printf("option name SolverHash type spin default %d min %d max %d\n",
+        (int)SEARCH_PARAMS_DEFAULT.solver_hash_size, UCI_OPTION_HASH_MIN, UCI_OPTION_HASH_MAX);
+    printf("option name UseMTDf type check default %s\n",
+        SEARCH_PARAMS_DEFAULT.is_mtdf_enabled ? "true" : "false");
+    printf("option name UseMCTS type check default %s\n",
+        SEARCH_PARAMS_DEFAULT.is_mcts_enabled ? "true" : "false");
+    printf("option name MCTSHash type spin default %d min %d max %d\n",
+        (int)SEARCH_PARAMS_DEFAULT.mcts_hash_size, UCI_OPTION_HASH_MIN, UCI_OPTION_HASH_MAX);
+}
+
 void uci_send_uciok(void)
 {
     printf("uciok\n");
@@ -211,44 +391,173 @@ void uci_send_readyok(void)
 void uci_send_bestmove(UCIState* uci)
 {
     assert(uci != NULL);
+    // no legal move, the null move is what GUIs expect
+    if (!uci->bestmove.from)
+    {
+        printf("bestmove 0000\n");
+        return;
+    }
     char bestmove_str[MOVE_TO_STRING_SIZE];
     move_to_string(&uci->bestmove, bestmove_str, MOVE_TO_STRING_SIZE);
-    printf("bestmove %s\n", bestmove_str);
+    if (!uci->pondermove.from)
+    {
+        printf("bestmove %s\n", bestmove_str);
+        return;
+    }
+    char pondermove_str[MOVE_TO_STRING_SIZE];
+    move_to_string(&uci->pondermove, pondermove_str, MOVE_TO_STRING_SIZE);
+    printf("bestmove %s ponder %s\n", bestmove_str, pondermove_str);
 }
 
-void* uci_search_loop(void* arg)
+// one info line per multipv line, best first
+void uci_send_info_lines(UCIState* uci, const SearchThread* thread)
 {
-    assert(arg != NULL);
-    UCIState* uci           = arg;
-    const BoardState* state = &uci->state;
-    Move moves[BOARD_STATE_MOVES_SIZE];
-    const size_t moves_size = board_state_get_legal_moves(state, moves, BOARD_STATE_MOVES_SIZE);
-    if (moves_size == 0)
-        return NULL;
-    switch (uci->search_mode)
+    assert(uci != NULL);
+    assert(thread != NULL);
+    const uint64_t nodes    = search_pool_get_nodes(&uci->pool);
+    const double elapsed    = time_manager_elapsed(&thread->time_manager);
+    const uint64_t nps      = (elapsed > 0) ? (uint64_t)(1000.0 * nodes / elapsed) : 0;
+    const uint64_t hashfull = transposition_table_hashfull(&uci->tt);
+    for (size_t i=0; i<thread->lines_size; ++i)
     {
-        case UCI_SEARCH_MODE_DEPTH:
+        const SearchLine* line = &thread->lines[i];
+        char score_str[UCI_SCORE_STRING_SIZE];
+        uci_score_to_string(line->score, score_str, UCI_SCORE_STRING_SIZE);
+        char pv_str[UCI_PV_STRING_SIZE] = {0};
+        for (size_t j=0; j<line->pv_size; ++j)
         {
-            evaluation_t max_evaluation = -INFINITY;
-            for (size_t i=0; i<moves_size; ++i)
-            {
-                const Move* move = &moves[i];
-                BoardState copy  = {0};
-                board_state_copy(state, &copy);
-                board_state_apply_move(&copy, move);
-                const evaluation_t evaluation = -board_state_evaluate_minimax(&copy, uci->depth);
-                if (evaluation > max_evaluation)
-                {
-                    max_evaluation = evaluation;
-                    uci->bestmove  = *move;
-                }
-            }
-            break;
+            char move_str[MOVE_TO_STRING_SIZE];
+            move_to_string(&line->pv[j], move_str, MOVE_TO_STRING_SIZE);
+            if (j > 0)
+                strncat(pv_str, " ", UCI_PV_STRING_SIZE - strlen(pv_str) - 1);
+            strncat(pv_str, move_str, UCI_PV_STRING_SIZE - strlen(pv_str) - 1);
         }
-        default: break;
+        printf("info depth %lu seldepth %lu multipv %lu score %s nodes %lu nps %lu hashfull %lu time %lu pv %s\n",
+            (unsigned long)thread->depth, (unsigned long)thread->stats.seldepth, (unsigned long)(i+1), score_str,
+            (unsigned long)nodes, (unsigned long)nps, (unsigned long)hashfull, (unsigned long)elapsed, pv_str);
     }
-    char bestmove_str[MOVE_TO_STRING_SIZE];
-    move_to_string(&uci->bestmove, bestmove_str, MOVE_TO_STRING_SIZE);
-    return NULL;
+}
+
+// sent by the dialog thread while the pool is searching
+void uci_send_info_stats(UCIState* uci)
+{
+    assert(uci != NULL);
+    SearchStats stats;
+    search_pool_get_stats(&uci->pool, &stats);
+    const double elapsed = 1000.0 * (time_now_seconds() - uci->search_start);
+    const uint64_t nps   = (elapsed > 0) ? (uint64_t)(1000.0 * stats.nodes / elapsed) : 0;
+    printf("info time %lu nodes %lu nps %lu hashfull %lu seldepth %lu\n",
+        (unsigned long)elapsed, (unsigned long)stats.nodes, (unsigned long)nps,
+        (unsigned long)transposition_table_hashfull(&uci->tt), (unsigned long)stats.seldepth);
+}
+
+// the extended counters, summed over all threads
+void uci_send_info_debug(UCIState* uci)
+{
+    assert(uci != NULL);
+    SearchStats stats;
+    search_pool_get_stats(&uci->pool, &stats);
+    printf("info string qnodes %lu ttprobes %lu tthits %lu (%.1f%%) cutoffs %lu firstmove %.1f%% "
+        "nullcutoffs %lu lmrresearches %lu extensions %lu\n",
+        (unsigned long)stats.qnodes, (unsigned long)stats.tt_probes, (unsigned long)stats.tt_hits,
+        stats.tt_probes ? 100.0 * stats.tt_hits / stats.tt_probes : 0.0,
+        (unsigned long)stats.beta_cutoffs,
+        stats.beta_cutoffs ? 100.0 * stats.first_move_cutoffs / stats.beta_cutoffs : 0.0,
+        (unsigned long)stats.null_move_cutoffs, (unsigned long)stats.lmr_researches,
+        (unsigned long)stats.extensions);
+}
+
+// playouts per second and the size of the shared tree
+void uci_send_info_mcts(UCIState* uci)
+{
+    assert(uci != NULL);
+    SearchStats stats;
+    search_pool_get_stats(&uci->pool, &stats);
+    const double elapsed = 1000.0 * (time_now_seconds() - uci->search_start);
+    const uint64_t pps   = (elapsed > 0) ? (uint64_t)(1000.0 * stats.playouts / elapsed) : 0;
+    printf("info string playouts %lu pps %lu treenodes %lu memory %luMB\n",
+        (unsigned long)stats.playouts, (unsigned long)pps,
+        (unsigned long)simp_tree_mcts_size(&uci->pool.mcts),
+        (unsigned long)(mcts_get_memory(&uci->pool.mcts) / (1 << 20)));
+}
+
+// block until a command arrives, reporting progress every interval while a search runs
+void uci_wait_for_input(UCIState* uci)
+{
+    assert(uci != NULL);
+    struct pollfd input = { .fd = fileno(stdin), .events = POLLIN };
+    while (search_pool_is_searching(&uci->pool) && poll(&input, 1, UCI_INFO_INTERVAL) == 0)
+    {
+        if (!search_pool_is_searching(&uci->pool))
+            break;
+        uci_send_info_stats(uci);
+        if (uci->params.is_mcts_enabled)
+            uci_send_info_mcts(uci);
+        if (uci->debug_flag)
+            uci_send_info_debug(uci);
+    }
+}
+
+// mate scores are sent in moves, not plies, negative when we are the one getting mated
+void uci_score_to_string(evaluation_t score, char* str, size_t str_size)
+{
+    assert(str != NULL);
+    if (!evaluation_is_mate(score))
+        snprintf(str, str_size, "cp %d", score);
+    else if (score > 0)
+        snprintf(str, str_size, "mate %d", (EVALUATION_MATE - score + 1) / 2);
+    else
+        snprintf(str, str_size, "mate %d", -(EVALUATION_MATE + score) / 2);
+}
+
+// the expected reply is the second pv move, or else the table move after our best move, if it is legal
+Move uci_get_pondermove(UCIState* uci, const SearchThread* thread)
+{
+    assert(uci != NULL);
+    assert(thread != NULL);
+    const Move* bestmove = &thread->bestmove;
+    if (!bestmove->from)
+        return (Move){0};
+    if (thread->lines_size > 0 && thread->lines[0].pv_size > 1 && move_is_equal(&thread->lines[0].pv[0], bestmove))
+        return thread->lines[0].pv[1];
+    BoardState copy = {0};
+    board_state_copy(&uci->state, &copy);
+    if (board_state_apply_move(&copy, bestmove) != APPLY_MOVE_STATUS_OK)
+        return (Move){0};
+    TranspositionTableRecord record;
+    if (!transposition_table_probe(&uci->tt, board_state_get_hash(&copy), 0, &record))
+        return (Move){0};
+    Move moves[BOARD_STATE_MOVES_SIZE];
+    const size_t moves_size = board_state_get_legal_moves(&copy, moves, BOARD_STATE_MOVES_SIZE);
+    for (size_t i=0; i<moves_size; ++i)
+        if (move_is_equal(&moves[i], &record.move))
+            return moves[i];
+    return (Move){0};
+}
+
+void uci_search_iteration(void* arg, const SearchThread* thread)
+{
+    assert(arg != NULL);
+    assert(thread != NULL);
+    UCIState* uci = arg;
+    uci_send_info_lines(uci, thread);
+    if (uci->params.is_mcts_enabled)
+        uci_send_info_mcts(uci);
+    if (uci->debug_flag)
+        uci_send_info_debug(uci);
+}
+
+void uci_search_finish(void* arg, const SearchThread* thread)
+{
+    assert(arg != NULL);
+    assert(thread != NULL);
+    UCIState* uci = arg;
+    // an infinite or ponder search may run out of depth, but must not answer before stop or ponderhit
+    while ((uci->search_mode == UCI_SEARCH_MODE_INFINITE || search_pool_is_pondering(&uci->pool))
+        && !search_pool_is_stopped(&uci->pool))
+        time_sleep_milliseconds(1);
+    uci->bestmove   = thread->bestmove;
+    uci->pondermove = uci_get_pondermove(uci, thread);
+    uci_send_bestmove(uci);
 }
 
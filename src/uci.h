@@ -6,19 +6,21 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <pthread.h>
 
 #include "board_state.h"
+#include "transposition_table.h"
+#include "search.h"
+#include "search_pool.h"
 #include "dyn_array.h"
-#include "simp_tree.h"
-
-DEFINE_DYN_ARRAY(pthread_t, dyn_array_pthread)
-DEFINE_SIMP_TREE(Move, simp_tree_move)
 
 typedef enum
 {
     UCI_SEARCH_MODE_STOP,
     UCI_SEARCH_MODE_DEPTH,
+    UCI_SEARCH_MODE_MOVETIME,
+    UCI_SEARCH_MODE_CLOCK,
+    UCI_SEARCH_MODE_NODES,
+    UCI_SEARCH_MODE_MATE,
     UCI_SEARCH_MODE_INFINITE,
     UCI_SEARCH_MODE_PONDER,
 } uci_search_mode_t;
@@ -27,18 +29,38 @@ typedef struct
 {
     BoardState state;
     Move bestmove;
+    Move pondermove;
     uci_search_mode_t search_mode;
-    uint64_t depth;
+    SearchParams params;
+    SearchLimits limits;
+    uint64_t move_overhead;
+    bool is_ponder_enabled;
+    // in seconds, for the periodic info lines
+    double search_start;
     bool debug_flag;
-    dyn_array_pthread threads;
+    TranspositionTable tt;
+    SearchPool pool;
 } UCIState;
 
 #define UCI_BUFFER_SIZE 256
+// milliseconds between info lines while searching
+#define UCI_INFO_INTERVAL 1000
 #define UCI_TOKENS_SIZE 64
 
 #define UCI_CNOOBDOGG_NAME "cnoobdogg 0.1"
 #define UCI_CNOOBDOGG_AUTHOR "Thomas Hua"
 
+#define UCI_OPTION_HASH_DEFAULT 16
+#define UCI_OPTION_HASH_MIN 1
+#define UCI_OPTION_HASH_MAX 4096
+#define UCI_OPTION_MARGIN_MAX 1000
+#define UCI_OPTION_MOVE_OVERHEAD_MAX 5000
+#define UCI_OPTION_THREADS_DEFAULT SEARCH_POOL_WORKERS_DEFAULT
+#define UCI_OPTION_THREADS_MAX SEARCH_POOL_WORKERS_MAX
+#define UCI_OPTION_MULTIPV_MAX SEARCH_MULTIPV_MAX
+#define UCI_SCORE_STRING_SIZE 32
+#define UCI_PV_STRING_SIZE ((SEARCH_DEPTH_MAX + 1) * MOVE_TO_STRING_SIZE)
+
 void uci_state_init(UCIState* uci);
 
 void uci_run_dialog(void);
@@ -46,17 +68,30 @@ void uci_run_dialog(void);
 void uci_cmd_uci(void);
 void uci_cmd_debug(UCIState* uci, char** tokens, size_t tokens_size);
 void uci_cmd_isready(void);
+void uci_cmd_setoption(UCIState* uci, char** tokens, size_t tokens_size);
 void uci_cmd_position(UCIState* uci, char** tokens, size_t tokens_size);
 void uci_cmd_go(UCIState* uci, char** tokens, size_t tokens_size);
 void uci_cmd_stop(UCIState* uci);
+void uci_cmd_ponderhit(UCIState* uci);
 void uci_cmd_quit(void);
 
 void uci_send_id(void);
+void uci_send_options(void);
 void uci_send_uciok(void);
 void uci_send_readyok(void);
 void uci_send_bestmove(UCIState* uci);
+void uci_send_info_lines(UCIState* uci, const SearchThread* thread);
+void uci_send_info_stats(UCIState* uci);
+void uci_send_info_debug(UCIState* uci);
+void uci_send_info_mcts(UCIState* uci);
+
+void uci_wait_for_input(UCIState* uci);
+
+void uci_score_to_string(evaluation_t score, char* str, size_t str_size);
 
-void* uci_search_loop(void* arg);
+Move uci_get_pondermove(UCIState* uci, const SearchThread* thread);
+void uci_search_iteration(void* arg, const SearchThread* thread);
+void uci_search_finish(void* arg, const SearchThread* thread);
 
 #endif // UCI_H
 
@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 199309L
 #include "utils.h"
 
 #include <stdio.h>
@@ -5,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
 
 // "Determining if an integer is a power of 2", Anderson, _Bit Twiddling Hacks_
 // http://www.graphics.stanford.edu/~seander/bithacks.html#DetermineIfPowerOf2
@@ -58,3 +60,26 @@ void string_tokenize_alloc(char* str, dyn_array_char_ptr* buffer)
     }
 }
 
+// "splitmix64.c", Vigna, _xoshiro / xoroshiro generators and the PRNG shootout_
+// https://prng.di.unimi.it/splitmix64.c
+uint64_t splitmix64(uint64_t n)
+{
+    uint64_t z = n + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+double time_now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void time_sleep_milliseconds(uint64_t ms)
+{
+    const struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
@@ -12,6 +12,9 @@ bool is_power_of_two(uint64_t n);
 void uint64_to_string(uint64_t n, char* str, size_t str_size);
 uint64_t abs_diff(uint64_t a, uint64_t b);
 void string_tokenize_alloc(char* str, dyn_array_char_ptr* buffer);
+uint64_t splitmix64(uint64_t n);
+double time_now_seconds(void);
+void time_sleep_milliseconds(uint64_t ms);
 
 #endif // UTILS_H
 